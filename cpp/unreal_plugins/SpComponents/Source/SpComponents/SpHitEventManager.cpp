@@ -4,9 +4,16 @@
 
 #include "SpComponents/SpHitEventManager.h"
 
+#include <stdint.h> // uint64_t
+
+#include <algorithm> // std::binary_search, std::sort
 #include <map>
+#include <memory>    // std::make_unique
+#include <string>
+#include <vector>
 
 #include <Containers/Array.h>
+#include <CoreGlobals.h>            // GFrameCounter
 #include <Engine/EngineBaseTypes.h> // ETickingGroup
 #include <Engine/EngineTypes.h>     // FHitResult
 #include <GameFramework/Actor.h>
@@ -14,12 +21,48 @@
 
 #include "SpCore/Assert.h"
 #include "SpCore/Log.h"
+#include "SpCore/SharedMemoryRegion.h"
+#include "SpCore/SpFuncArray.h"
 #include "SpCore/SpStableNameComponent.h"
 #include "SpCore/Std.h"
 #include "SpCore/Unreal.h"
+#include "SpCore/Yaml.h"
+#include "SpCore/YamlCpp.h"
+
+#include "SpComponents/SpFuncComponent.h"
+
+// Initial capacity of our shared memory regions. If a frame has more hits than the current capacity, the regions
+// are grown, see growSharedMemoryRegions(...).
+static constexpr uint64_t INITIAL_NUM_SHARED_MEMORY_HIT_EVENTS = 4096;
+
+static const std::map<std::string, uint64_t> s_shared_memory_num_bytes_per_hit_event_ = {
+    {"hit_events.self_actors",     sizeof(uint64_t)},
+    {"hit_events.other_actors",    sizeof(uint64_t)},
+    {"hit_events.impact_points",   3*sizeof(double)},
+    {"hit_events.normals",         3*sizeof(double)},
+    {"hit_events.normal_impulses", 3*sizeof(double)},
+    {"hit_events.frame_ids",       sizeof(uint64_t)}};
 
 static std::map<AActor*, bool> s_record_debug_info_map_;
-static TArray<FActorHitEventDesc> s_actor_hit_event_descs_;
+static int s_num_record_debug_info_actors_ = 0;
+
+// index 0 or 1 is the back buffer depending on s_back_buffer_index_, and the other index is the front buffer
+static SpHitEventColumns s_hit_event_columns_[2];
+static TArray<FActorHitEventDesc> s_actor_hit_event_descs_[2];
+static TArray<FActorHitEventDesc> s_debug_actor_hit_event_descs_[2]; // only hits for actors with bRecordDebugInfo set
+static int s_back_buffer_index_ = 0;
+static uint64_t s_last_swap_frame_id_ = -1;
+
+void SpHitEventColumns::clear()
+{
+    // std::vector::clear() keeps the allocated capacity, so we don't allocate in steady state
+    self_actors_.clear();
+    other_actors_.clear();
+    impact_points_.clear();
+    normals_.clear();
+    normal_impulses_.clear();
+    frame_ids_.clear();
+}
 
 ASpHitEventManager::ASpHitEventManager()
 {
@@ -27,7 +70,12 @@ ASpHitEventManager::ASpHitEventManager()
 
     PrimaryActorTick.bCanEverTick = true;
     PrimaryActorTick.bTickEvenWhenPaused = false;
-    PrimaryActorTick.TickGroup = ETickingGroup::TG_PrePhysics;
+    PrimaryActorTick.TickGroup = ETickingGroup::TG_PostUpdateWork; // swap after all hits for the frame have been recorded
+
+    SpFuncComponent = Unreal::createComponentInsideOwnerConstructor<USpFuncComponent>(this, "sp_func_component");
+    SP_ASSERT(SpFuncComponent);
+
+    initializeSpFuncs();
 }
 
 ASpHitEventManager::~ASpHitEventManager()
@@ -35,10 +83,27 @@ ASpHitEventManager::~ASpHitEventManager()
     SP_LOG_CURRENT_FUNCTION();
 }
 
+void ASpHitEventManager::BeginDestroy()
+{
+    AActor::BeginDestroy();
+
+    terminateSpFuncs();
+}
+
 void ASpHitEventManager::Tick(float delta_time)
 {
     AActor::Tick(delta_time);
-    s_actor_hit_event_descs_.Empty();
+
+    // there might be more than one instance in the world, so make sure we only swap once per frame
+    if (s_last_swap_frame_id_ == GFrameCounter) {
+        return;
+    }
+    s_last_swap_frame_id_ = GFrameCounter;
+
+    s_back_buffer_index_ = 1 - s_back_buffer_index_;
+    s_hit_event_columns_[s_back_buffer_index_].clear();
+    s_actor_hit_event_descs_[s_back_buffer_index_].Reset(); // keeps the allocated capacity
+    s_debug_actor_hit_event_descs_[s_back_buffer_index_].Reset();
 }
 
 void ASpHitEventManager::SubscribeToActor(AActor* Actor, bool bRecordDebugInfo)
@@ -51,6 +116,9 @@ void ASpHitEventManager::SubscribeToActor(AActor* Actor, bool bRecordDebugInfo)
 
     Actor->OnActorHit.AddDynamic(Cast<ASpHitEventManager>(ASpHitEventManager::StaticClass()->GetDefaultObject()), &ASpHitEventManager::ActorHitHandler); // no RTTI available
     Std::insert(s_record_debug_info_map_, Actor, bRecordDebugInfo);
+    if (bRecordDebugInfo) {
+        s_num_record_debug_info_actors_++;
+    }
 }
 
 void ASpHitEventManager::UnsubscribeFromActor(AActor* Actor)
@@ -58,19 +126,54 @@ void ASpHitEventManager::UnsubscribeFromActor(AActor* Actor)
     SP_ASSERT(Actor);
 
     Actor->OnActorHit.RemoveDynamic(Cast<ASpHitEventManager>(ASpHitEventManager::StaticClass()->GetDefaultObject()), &ASpHitEventManager::ActorHitHandler); // no RTTI available
+    if (Std::containsKey(s_record_debug_info_map_, Actor) && s_record_debug_info_map_.at(Actor)) {
+        s_num_record_debug_info_actors_--;
+    }
     Std::remove(s_record_debug_info_map_, Actor);
 }
 
 TArray<FActorHitEventDesc> ASpHitEventManager::GetHitEventDescs()
 {
-    return s_actor_hit_event_descs_;
+    return s_actor_hit_event_descs_[1 - s_back_buffer_index_];
+}
+
+TArray<FActorHitEventDesc> ASpHitEventManager::GetDebugHitEventDescs()
+{
+    return s_debug_actor_hit_event_descs_[1 - s_back_buffer_index_];
+}
+
+const SpHitEventColumns& ASpHitEventManager::getHitEvents()
+{
+    return s_hit_event_columns_[1 - s_back_buffer_index_];
+}
+
+std::vector<uint64_t> ASpHitEventManager::getHitEventIndices(const std::vector<uint64_t>& actors)
+{
+    std::vector<uint64_t> sorted_actors = actors;
+    std::sort(sorted_actors.begin(), sorted_actors.end());
+
+    const SpHitEventColumns& hit_events = getHitEvents();
+    std::vector<uint64_t> hit_event_indices;
+    for (uint64_t i = 0; i < hit_events.getNumEvents(); i++) {
+        if (std::binary_search(sorted_actors.begin(), sorted_actors.end(), hit_events.self_actors_.at(i))) {
+            hit_event_indices.push_back(i);
+        }
+    }
+    return hit_event_indices;
 }
 
 void ASpHitEventManager::ActorHitHandler(AActor* SelfActor, AActor* OtherActor, FVector NormalImpulse, const FHitResult& HitResult)
 {
     SP_ASSERT(SelfActor);
     SP_ASSERT(OtherActor);
-    SP_ASSERT(Std::containsKey(s_record_debug_info_map_, SelfActor));
+
+    SpHitEventColumns& hit_events = s_hit_event_columns_[s_back_buffer_index_];
+    hit_events.self_actors_.push_back(reinterpret_cast<uint64_t>(SelfActor));
+    hit_events.other_actors_.push_back(reinterpret_cast<uint64_t>(OtherActor));
+    hit_events.impact_points_.insert(hit_events.impact_points_.end(), {HitResult.ImpactPoint.X, HitResult.ImpactPoint.Y, HitResult.ImpactPoint.Z});
+    hit_events.normals_.insert(hit_events.normals_.end(), {HitResult.ImpactNormal.X, HitResult.ImpactNormal.Y, HitResult.ImpactNormal.Z});
+    hit_events.normal_impulses_.insert(hit_events.normal_impulses_.end(), {NormalImpulse.X, NormalImpulse.Y, NormalImpulse.Z});
+    hit_events.frame_ids_.push_back(GFrameCounter);
 
     FActorHitEventDesc actor_hit_event_desc;
     actor_hit_event_desc.SelfActor = reinterpret_cast<uint64>(SelfActor);
@@ -78,12 +181,147 @@ void ASpHitEventManager::ActorHitHandler(AActor* SelfActor, AActor* OtherActor,
     actor_hit_event_desc.NormalImpulse = NormalImpulse;
     actor_hit_event_desc.HitResult = HitResult;
 
-    if (s_record_debug_info_map_.at(SelfActor)) {
-        actor_hit_event_desc.SelfActorPtr = Unreal::toFString(Std::toStringFromPtr(SelfActor));
-        actor_hit_event_desc.SelfActorPropertiesString = Unreal::toFString(Unreal::getObjectPropertiesAsString(SelfActor));
-        actor_hit_event_desc.OtherActorPtr = Unreal::toFString(Std::toStringFromPtr(OtherActor));
-        actor_hit_event_desc.OtherActorPropertiesString = Unreal::toFString(Unreal::getObjectPropertiesAsString(OtherActor));
+    // only pay for a map lookup and building the debug info if some actor wants it
+    if (s_num_record_debug_info_actors_ > 0) {
+        SP_ASSERT(Std::containsKey(s_record_debug_info_map_, SelfActor));
+        if (s_record_debug_info_map_.at(SelfActor)) {
+            actor_hit_event_desc.SelfActorPtr = Unreal::toFString(Std::toStringFromPtr(SelfActor));
+            actor_hit_event_desc.SelfActorPropertiesString = Unreal::toFString(Unreal::getObjectPropertiesAsString(SelfActor));
+            actor_hit_event_desc.OtherActorPtr = Unreal::toFString(Std::toStringFromPtr(OtherActor));
+            actor_hit_event_desc.OtherActorPropertiesString = Unreal::toFString(Unreal::getObjectPropertiesAsString(OtherActor));
+            s_debug_actor_hit_event_descs_[s_back_buffer_index_].Add(actor_hit_event_desc);
+        }
+    }
+
+    s_actor_hit_event_descs_[s_back_buffer_index_].Add(actor_hit_event_desc);
+}
+
+void ASpHitEventManager::initializeSpFuncs()
+{
+    // The number of hits per frame is unbounded, so our regions are growable. Clients should access them with
+    // spear.shared_memory.GrowableSharedMemoryRegion, which skips the region header and remaps the region when it
+    // has been grown.
+    shared_memory_num_hit_events_ = INITIAL_NUM_SHARED_MEMORY_HIT_EVENTS;
+    for (auto& [shared_memory_name, num_bytes_per_hit_event] : s_shared_memory_num_bytes_per_hit_event_) {
+        std::unique_ptr<SharedMemoryRegion> shared_memory_region = std::make_unique<SharedMemoryRegion>(
+            shared_memory_num_hit_events_*num_bytes_per_hit_event, SharedMemoryRegionFlags::Growable);
+        SP_ASSERT(shared_memory_region);
+        SpFuncSharedMemoryView shared_memory_view(shared_memory_region->getView(), SpFuncSharedMemoryUsageFlags::ReturnValue);
+        SpFuncComponent->registerSharedMemoryView(shared_memory_name, shared_memory_view);
+        Std::insert(shared_memory_views_, shared_memory_name, shared_memory_view);
+        Std::insert(shared_memory_regions_, shared_memory_name, std::move(shared_memory_region));
     }
 
-    s_actor_hit_event_descs_.Add(actor_hit_event_desc);
+    // Returns all hits from the most recent frame. If the optional "actor_filter" arg is provided, only hits whose
+    // self actor is in actor_filter are returned. If USE_SHARED_MEMORY is true in the info string, the returned
+    // arrays are backed by shared memory, and our shared memory regions are grown if they are too small.
+    SpFuncComponent->registerFunc("get_hit_events", [this](SpFuncDataBundle& args) -> SpFuncDataBundle {
+
+        bool use_shared_memory = false;
+        if (!args.info_.empty()) {
+            use_shared_memory = Yaml::get<bool>(YAML::Load(args.info_), "USE_SHARED_MEMORY");
+        }
+
+        const SpHitEventColumns& hit_events = getHitEvents();
+
+        std::vector<uint64_t> hit_event_indices;
+        if (Std::containsKey(args.packed_arrays_, "actor_filter")) {
+            SpFuncArrayView<uint64_t> actor_filter("actor_filter");
+            SpFuncArrayUtils::setViewsFromPackedArrays({actor_filter.getPtr()}, args.packed_arrays_);
+            hit_event_indices = getHitEventIndices(Std::toVector<uint64_t>(actor_filter.getView()));
+        } else {
+            hit_event_indices.resize(hit_events.getNumEvents());
+            for (uint64_t i = 0; i < hit_events.getNumEvents(); i++) {
+                hit_event_indices.at(i) = i;
+            }
+        }
+
+        uint64_t num_events = hit_event_indices.size();
+        std::vector<uint64_t> self_actors(num_events);
+        std::vector<uint64_t> other_actors(num_events);
+        std::vector<double> impact_points(3*num_events);
+        std::vector<double> normals(3*num_events);
+        std::vector<double> normal_impulses(3*num_events);
+        std::vector<uint64_t> frame_ids(num_events);
+        for (uint64_t i = 0; i < num_events; i++) {
+            uint64_t j = hit_event_indices.at(i);
+            self_actors.at(i) = hit_events.self_actors_.at(j);
+            other_actors.at(i) = hit_events.other_actors_.at(j);
+            frame_ids.at(i) = hit_events.frame_ids_.at(j);
+            for (int k = 0; k < 3; k++) {
+                impact_points.at(3*i + k) = hit_events.impact_points_.at(3*j + k);
+                normals.at(3*i + k) = hit_events.normals_.at(3*j + k);
+                normal_impulses.at(3*i + k) = hit_events.normal_impulses_.at(3*j + k);
+            }
+        }
+
+        SpFuncArray<uint64_t> self_actors_array("self_actors");
+        SpFuncArray<uint64_t> other_actors_array("other_actors");
+        SpFuncArray<double> impact_points_array("impact_points");
+        SpFuncArray<double> normals_array("normals");
+        SpFuncArray<double> normal_impulses_array("normal_impulses");
+        SpFuncArray<uint64_t> frame_ids_array("frame_ids");
+
+        if (use_shared_memory) {
+            if (num_events > shared_memory_num_hit_events_) {
+                growSharedMemoryRegions(num_events);
+            }
+            self_actors_array.setData("hit_events.self_actors", shared_memory_views_.at("hit_events.self_actors"), {num_events});
+            other_actors_array.setData("hit_events.other_actors", shared_memory_views_.at("hit_events.other_actors"), {num_events});
+            impact_points_array.setData("hit_events.impact_points", shared_memory_views_.at("hit_events.impact_points"), {num_events, 3});
+            normals_array.setData("hit_events.normals", shared_memory_views_.at("hit_events.normals"), {num_events, 3});
+            normal_impulses_array.setData("hit_events.normal_impulses", shared_memory_views_.at("hit_events.normal_impulses"), {num_events, 3});
+            frame_ids_array.setData("hit_events.frame_ids", shared_memory_views_.at("hit_events.frame_ids"), {num_events});
+            self_actors_array.setDataValues(self_actors);
+            other_actors_array.setDataValues(other_actors);
+            impact_points_array.setDataValues(impact_points);
+            normals_array.setDataValues(normals);
+            normal_impulses_array.setDataValues(normal_impulses);
+            frame_ids_array.setDataValues(frame_ids);
+        } else {
+            int64_t num_events_int64 = num_events;
+            self_actors_array.setData(self_actors, {num_events_int64});
+            other_actors_array.setData(other_actors, {num_events_int64});
+            impact_points_array.setData(impact_points, {num_events_int64, 3});
+            normals_array.setData(normals, {num_events_int64, 3});
+            normal_impulses_array.setData(normal_impulses, {num_events_int64, 3});
+            frame_ids_array.setData(frame_ids, {num_events_int64});
+        }
+
+        SpFuncDataBundle return_values;
+        return_values.packed_arrays_ = SpFuncArrayUtils::moveToPackedArrays({
+            self_actors_array.getPtr(), other_actors_array.getPtr(), impact_points_array.getPtr(),
+            normals_array.getPtr(), normal_impulses_array.getPtr(), frame_ids_array.getPtr()});
+        return return_values;
+    });
+}
+
+void ASpHitEventManager::growSharedMemoryRegions(uint64_t num_hit_events)
+{
+    // double the capacity until it's big enough, so frequent small increases don't cause frequent resizes
+    while (shared_memory_num_hit_events_ < num_hit_events) {
+        shared_memory_num_hit_events_ *= 2;
+    }
+    SP_LOG("Growing hit event shared memory regions to ", shared_memory_num_hit_events_, " hit events...");
+
+    // resizing can change the address of each region, and its ID on Windows, so we register new views
+    for (auto& [shared_memory_name, num_bytes_per_hit_event] : s_shared_memory_num_bytes_per_hit_event_) {
+        SharedMemoryRegion* shared_memory_region = shared_memory_regions_.at(shared_memory_name).get();
+        shared_memory_region->resize(shared_memory_num_hit_events_*num_bytes_per_hit_event);
+        SpFuncSharedMemoryView shared_memory_view(shared_memory_region->getView(), SpFuncSharedMemoryUsageFlags::ReturnValue);
+        SpFuncComponent->unregisterSharedMemoryView(shared_memory_name);
+        SpFuncComponent->registerSharedMemoryView(shared_memory_name, shared_memory_view);
+        shared_memory_views_.at(shared_memory_name) = shared_memory_view;
+    }
+}
+
+void ASpHitEventManager::terminateSpFuncs()
+{
+    SpFuncComponent->unregisterFunc("get_hit_events");
+
+    for (auto& [shared_memory_name, shared_memory_view] : shared_memory_views_) {
+        SpFuncComponent->unregisterSharedMemoryView(shared_memory_name);
+    }
+    shared_memory_views_.clear();
+    shared_memory_regions_.clear();
 }
@@ -4,7 +4,12 @@
 
 #pragma once
 
+#include <stdint.h> // uint64_t
+
 #include <map>
+#include <memory> // std::unique_ptr
+#include <string>
+#include <vector>
 
 #include <Containers/Array.h>
 #include <Containers/UnrealString.h> // FString
@@ -14,12 +19,32 @@
 #include <Math/Vector.h>
 #include <UObject/ObjectMacros.h>    // GENERATED_BODY, UCLASS, UFUNCTION, UPROPERTY
 
+#include "SpCore/SharedMemoryRegion.h"
+#include "SpCore/SpFuncArray.h"
 #include "SpCore/SpStableNameComponent.h"
 
+#include "SpComponents/SpFuncComponent.h"
+
 #include "SpHitEventManager.generated.h"
 
 class USpStableNameComponent;
 
+// Hit events are stored in columns rather than as an array of FActorHitEventDesc structs, so recording a hit
+// doesn't allocate once the columns have reached their working size, and so all the hits in a frame can be
+// returned as a handful of packed arrays. Event i is described by element i of every column.
+struct SpHitEventColumns
+{
+    std::vector<uint64_t> self_actors_;
+    std::vector<uint64_t> other_actors_;
+    std::vector<double> impact_points_;   // 3 values per event
+    std::vector<double> normals_;         // 3 values per event
+    std::vector<double> normal_impulses_; // 3 values per event
+    std::vector<uint64_t> frame_ids_;     // value of GFrameCounter when the hit was recorded
+
+    uint64_t getNumEvents() const { return self_actors_.size(); }
+    void clear();
+};
+
 USTRUCT()
 struct FActorHitEventDesc
 {
@@ -54,6 +79,7 @@ public:
     ~ASpHitEventManager();
 
     // AActor interface
+    void BeginDestroy() override;
     void Tick(float delta_time) override;
 
     // Interface for subscribing to, unsubscribing from, and getting actor hit events. Part of this interface
@@ -67,10 +93,38 @@ public:
     UFUNCTION()
     static void UnsubscribeFromActor(AActor* Actor);
 
+    // Returns every hit from the most recent frame. The optional debug info is only populated for actors that were
+    // subscribed with bRecordDebugInfo set to true. getHitEvents() and the "get_hit_events" SpFunc return the same
+    // hits without building an FActorHitEventDesc for each one.
     UFUNCTION()
     static TArray<FActorHitEventDesc> GetHitEventDescs();
 
+    // Only returns hits for actors that were subscribed with bRecordDebugInfo set to true.
+    UFUNCTION()
+    static TArray<FActorHitEventDesc> GetDebugHitEventDescs();
+
+    // Hits are double-buffered. Hits are recorded into a back buffer while the world is ticking, and the buffers are
+    // swapped at the end of each frame, so getHitEvents() always returns every hit from the most recent frame that
+    // has finished ticking. Swapping requires an instance of ASpHitEventManager to be spawned in the world.
+    static const SpHitEventColumns& getHitEvents();
+
+    // Returns the indices of the events in getHitEvents() whose self actor is in actors. We sort a copy of actors
+    // and binary search it for each event, so filtering doesn't need any per-event hashing.
+    static std::vector<uint64_t> getHitEventIndices(const std::vector<uint64_t>& actors);
+
+    UPROPERTY(VisibleAnywhere, Category="SPEAR")
+    USpFuncComponent* SpFuncComponent = nullptr;
+
 private:
     UFUNCTION() // needs to be a UFUNCTION
     void ActorHitHandler(AActor* SelfActor, AActor* OtherActor, FVector NormalImpulse, const FHitResult& HitResult);
+
+    void initializeSpFuncs();
+    void terminateSpFuncs(); // don't call from destructor because SpFuncComponent might have been garbage-collected already
+    void growSharedMemoryRegions(uint64_t num_hit_events);
+
+    // one shared memory region per column, so each column can be returned as an SpFuncArray backed by shared memory
+    std::map<std::string, std::unique_ptr<SharedMemoryRegion>> shared_memory_regions_;
+    std::map<std::string, SpFuncSharedMemoryView> shared_memory_views_;
+    uint64_t shared_memory_num_hit_events_ = 0; // capacity of each shared memory region in hit events
 };
@@ -33,4 +33,5 @@ struct ArrayDesc
     DataType datatype_ = DataType::Invalid;
     bool use_shared_memory_ = false;
     std::string shared_memory_name_;
+    int shared_memory_num_slots_ = 1; // if greater than 1, the shared memory resource is laid out as described in SharedMemoryTripleBuffer.h
 };
@@ -73,6 +73,7 @@ SP_BEGIN_SUPPRESS_COMPILER_WARNINGS
         #error
     #endif
 
+    #include <boost/interprocess/file_mapping.hpp>
     #include <boost/interprocess/mapped_region.hpp>
 SP_END_SUPPRESS_COMPILER_WARNINGS
 
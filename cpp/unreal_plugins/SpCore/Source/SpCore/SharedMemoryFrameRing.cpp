@@ -0,0 +1,58 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpCore/SharedMemoryFrameRing.h"
+
+#include <stdint.h> // uint8_t, uint64_t
+#include <string.h> // memset
+
+#include <atomic>   // std::atomic_ref, std::memory_order
+
+#include "SpCore/Assert.h"
+
+uint64_t SharedMemoryFrameRing::getNumBytes(uint64_t num_slots, uint64_t slot_num_bytes)
+{
+    uint64_t slot_offset = (sizeof(SharedMemoryFrameRingHeader) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    uint64_t slot_stride = (slot_num_bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    return slot_offset + num_slots*slot_stride;
+}
+
+void SharedMemoryFrameRing::initialize(void* data, uint64_t num_slots, uint64_t slot_num_bytes)
+{
+    SP_ASSERT(data);
+    SP_ASSERT(num_slots > 0);
+    SP_ASSERT(slot_num_bytes > 0);
+
+    SharedMemoryFrameRingHeader* header = static_cast<SharedMemoryFrameRingHeader*>(data);
+    memset(header, 0, sizeof(SharedMemoryFrameRingHeader));
+    header->num_slots_ = num_slots;
+    header->slot_offset_ = (sizeof(SharedMemoryFrameRingHeader) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    header->slot_stride_ = (slot_num_bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+void* SharedMemoryFrameRing::tryBeginWrite(void* data)
+{
+    SP_ASSERT(data);
+    SharedMemoryFrameRingHeader* header = static_cast<SharedMemoryFrameRingHeader*>(data);
+
+    // Only the producer writes write_index_, so we don't need an atomic load here. The acquire load of read_index_
+    // guarantees that the consumer has finished reading a slot before we overwrite it.
+    uint64_t write_index = header->write_index_;
+    uint64_t read_index = std::atomic_ref<uint64_t>(header->read_index_).load(std::memory_order_acquire);
+    SP_ASSERT(read_index <= write_index);
+    if (write_index - read_index >= header->num_slots_) {
+        return nullptr;
+    }
+
+    return static_cast<uint8_t*>(data) + header->slot_offset_ + (write_index % header->num_slots_)*header->slot_stride_;
+}
+
+void SharedMemoryFrameRing::endWrite(void* data)
+{
+    SP_ASSERT(data);
+    SharedMemoryFrameRingHeader* header = static_cast<SharedMemoryFrameRingHeader*>(data);
+
+    // the release store guarantees that the contents of the slot are visible to the consumer before the new index
+    std::atomic_ref<uint64_t>(header->write_index_).store(header->write_index_ + 1, std::memory_order_release);
+}
@@ -0,0 +1,46 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint64_t
+
+//
+// A frame ring lets a producer stream a sequence of frames into shared memory while a consumer drains them
+// concurrently. Unlike a triple buffer, which only keeps the most recent frame, a frame ring never drops frames:
+// if every slot is still waiting to be consumed, the producer must wait. The shared memory resource begins with a
+// SharedMemoryFrameRingHeader, followed by num_slots_ equally sized slots. Frame i is written into slot
+// i % num_slots_. The producer publishes a frame by incrementing write_index_, and the consumer releases a frame
+// by incrementing read_index_. Both counters increase monotonically for the lifetime of the shared memory
+// resource. The layout of the header must be kept in sync with python/spear/env.py.
+//
+
+struct SharedMemoryFrameRingHeader
+{
+    uint64_t write_index_; // number of frames that have been published, written by the producer
+    uint64_t read_index_;  // number of frames that have been consumed, written by the consumer
+    uint64_t num_slots_;
+    uint64_t slot_offset_; // offset of the first slot relative to the start of the shared memory resource
+    uint64_t slot_stride_; // distance in bytes between consecutive slots
+};
+static_assert(sizeof(SharedMemoryFrameRingHeader) == 40);
+
+class SPCORE_API SharedMemoryFrameRing
+{
+public:
+    SharedMemoryFrameRing() = delete;
+    ~SharedMemoryFrameRing() = delete;
+
+    static constexpr uint64_t ALIGNMENT = 64;
+
+    // total number of bytes needed to store a header and num_slots slots of slot_num_bytes each
+    static uint64_t getNumBytes(uint64_t num_slots, uint64_t slot_num_bytes);
+
+    static void initialize(void* data, uint64_t num_slots, uint64_t slot_num_bytes);
+
+    // tryBeginWrite(...) returns a pointer to the slot that should be written, or nullptr if every slot is still
+    // waiting to be consumed, and endWrite(...) publishes it
+    static void* tryBeginWrite(void* data);
+    static void endWrite(void* data);
+};
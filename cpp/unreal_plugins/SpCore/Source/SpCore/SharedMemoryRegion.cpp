@@ -4,42 +4,54 @@
 
 #include "SpCore/SharedMemoryRegion.h"
 
-#include <stddef.h> // uint64_t
+#include <stddef.h> // size_t
+#include <stdint.h> // uint8_t, uint64_t
+#include <string.h> // memcpy, memset, strncpy
 
+#include <algorithm> // std::min
+#include <atomic>    // std::atomic_ref, std::memory_order
 #include <string>
+#include <utility>   // std::move
 
 #include "SpCore/Assert.h"
 #include "SpCore/Boost.h"
+#include "SpCore/Config.h"
+#include "SpCore/Log.h"
 
 // TODO: remove platform-specific include
 #if BOOST_COMP_MSVC
     #include <format>
 #endif
 
-SharedMemoryRegion::SharedMemoryRegion(int num_bytes) : SharedMemoryRegion(num_bytes, getUniqueId()) {}
+#if BOOST_OS_MACOS || BOOST_OS_LINUX
+    #include <sys/mman.h> // madvise, mlock
+#endif
+
+SharedMemoryRegion::SharedMemoryRegion(size_t num_bytes, SharedMemoryRegionFlags flags) : SharedMemoryRegion(num_bytes, getUniqueId(), flags) {}
 
-SharedMemoryRegion::SharedMemoryRegion(int num_bytes, uint64_t id)
+SharedMemoryRegion::SharedMemoryRegion(size_t num_bytes, uint64_t id, SharedMemoryRegionFlags flags)
 {
     SP_ASSERT(num_bytes > 0);
 
     id_ = getUniqueIdString(id);
     num_bytes_ = num_bytes;
+    flags_ = flags | getGlobalFlags();
 
     SP_ASSERT(id_ != "");
 
-    #if BOOST_OS_WINDOWS
-        boost::interprocess::windows_shared_memory windows_shared_memory(boost::interprocess::create_only, id_.c_str(), boost::interprocess::read_write, num_bytes_);
-        mapped_region_ = boost::interprocess::mapped_region(windows_shared_memory, boost::interprocess::read_write);
-    #elif BOOST_OS_MACOS || BOOST_OS_LINUX
+    #if BOOST_OS_MACOS || BOOST_OS_LINUX
         boost::interprocess::shared_memory_object::remove(id_.c_str());
-        boost::interprocess::shared_memory_object shared_memory_object(boost::interprocess::create_only, id_.c_str(), boost::interprocess::read_write);
-        shared_memory_object.truncate(num_bytes_);
-        mapped_region_ = boost::interprocess::mapped_region(shared_memory_object, boost::interprocess::read_write);
-    #else
-        #error
     #endif
 
-    SP_ASSERT(mapped_region_.get_address());
+    createMappedRegion();
+
+    if (!!(flags_ & SharedMemoryRegionFlags::Growable)) {
+        SharedMemoryRegionHeader* header = static_cast<SharedMemoryRegionHeader*>(mapped_region_.get_address());
+        SP_ASSERT(id_.size() < sizeof(header->id_));
+        header->generation_ = 0;
+        header->num_bytes_ = num_bytes_;
+        strncpy(header->id_, id_.c_str(), sizeof(header->id_) - 1);
+    }
 }
 
 SharedMemoryRegion::~SharedMemoryRegion()
@@ -55,10 +67,142 @@ SharedMemoryView SharedMemoryRegion::getView()
     SharedMemoryView view;
     view.id_ = id_;
     view.num_bytes_ = num_bytes_;
-    view.data_ = mapped_region_.get_address();
+    view.data_ = static_cast<uint8_t*>(mapped_region_.get_address()) + getHeaderNumBytes();
     return view;
 }
 
+void SharedMemoryRegion::resize(size_t num_bytes)
+{
+    SP_ASSERT(!!(flags_ & SharedMemoryRegionFlags::Growable));
+    SP_ASSERT(num_bytes > 0);
+
+    SharedMemoryRegionHeader* header = static_cast<SharedMemoryRegionHeader*>(mapped_region_.get_address());
+    uint64_t generation = header->generation_ + 1;
+
+    #if BOOST_OS_WINDOWS
+        // Named shared memory can't be resized on Windows, so we create a new region, copy the existing data into
+        // it, and point the old header at the new region. The old region remains valid until all other processes
+        // have closed their handles to it.
+        boost::interprocess::mapped_region old_mapped_region = std::move(mapped_region_);
+        uint64_t old_num_bytes = num_bytes_;
+
+        id_ = getUniqueIdString(getUniqueId());
+        num_bytes_ = num_bytes;
+        createMappedRegion();
+
+        memcpy(
+            static_cast<uint8_t*>(mapped_region_.get_address()) + getHeaderNumBytes(),
+            static_cast<uint8_t*>(old_mapped_region.get_address()) + getHeaderNumBytes(),
+            std::min(old_num_bytes, num_bytes_));
+
+        SP_ASSERT(id_.size() < sizeof(header->id_));
+        memset(header->id_, 0, sizeof(header->id_));
+        strncpy(header->id_, id_.c_str(), sizeof(header->id_) - 1);
+        std::atomic_ref<uint64_t>(header->generation_).store(generation, std::memory_order_release);
+    #elif BOOST_OS_MACOS || BOOST_OS_LINUX
+        // We resize the underlying shared memory object in place, which preserves its contents, and other processes
+        // keep their existing mappings, so they can read the header of the existing mapping to detect that they
+        // need to remap the region. We only support growing the region, because shrinking it in place would
+        // truncate the object underneath other processes that still map the larger size before they observe the
+        // new generation, and their next access beyond the new size would raise SIGBUS.
+        SP_ASSERT(num_bytes >= num_bytes_);
+        num_bytes_ = num_bytes;
+        mapped_region_ = boost::interprocess::mapped_region();
+        createMappedRegion();
+    #else
+        #error
+    #endif
+
+    header = static_cast<SharedMemoryRegionHeader*>(mapped_region_.get_address());
+    header->num_bytes_ = num_bytes_;
+    memset(header->id_, 0, sizeof(header->id_));
+    strncpy(header->id_, id_.c_str(), sizeof(header->id_) - 1);
+    std::atomic_ref<uint64_t>(header->generation_).store(generation, std::memory_order_release);
+}
+
+SharedMemoryRegionFlags SharedMemoryRegion::getGlobalFlags()
+{
+    SharedMemoryRegionFlags flags = SharedMemoryRegionFlags::None;
+    if (Config::isInitialized()) {
+        if (Config::get<bool>("SP_CORE.SHARED_MEMORY.USE_HUGE_PAGES")) {
+            flags = flags | SharedMemoryRegionFlags::HugePages;
+        }
+        if (Config::get<bool>("SP_CORE.SHARED_MEMORY.PREFAULT")) {
+            flags = flags | SharedMemoryRegionFlags::Prefault;
+        }
+        if (Config::get<bool>("SP_CORE.SHARED_MEMORY.LOCK")) {
+            flags = flags | SharedMemoryRegionFlags::Lock;
+        }
+    }
+    return flags;
+}
+
+void SharedMemoryRegion::applyFlags(boost::interprocess::mapped_region& mapped_region, SharedMemoryRegionFlags flags)
+{
+    void* data = mapped_region.get_address();
+    size_t num_bytes = mapped_region.get_size();
+    SP_ASSERT(data);
+
+    // Named POSIX shared memory objects live on tmpfs, which can't be mapped with MAP_HUGETLB, so we request
+    // transparent huge pages instead. This requires /sys/kernel/mm/transparent_hugepage/shmem_enabled to be set
+    // to "advise" or "always". Otherwise madvise(...) fails and we keep using regular pages.
+    if (!!(flags & SharedMemoryRegionFlags::HugePages)) {
+        #if BOOST_OS_LINUX
+            if (madvise(data, num_bytes, MADV_HUGEPAGE) != 0) {
+                SP_LOG("WARNING: Huge pages are not available for shared memory, falling back to regular pages.");
+            }
+        #else
+            SP_LOG("WARNING: Huge pages are only supported on Linux, falling back to regular pages.");
+        #endif
+    }
+
+    // Writing back the first byte of every page is a portable way to fault in every page for writing without
+    // changing the contents of the region.
+    if (!!(flags & SharedMemoryRegionFlags::Prefault)) {
+        mapped_region.advise(boost::interprocess::mapped_region::advice_willneed);
+        size_t page_size = boost::interprocess::mapped_region::get_page_size();
+        volatile uint8_t* bytes = static_cast<uint8_t*>(data);
+        for (size_t i = 0; i < num_bytes; i += page_size) {
+            bytes[i] = bytes[i];
+        }
+    }
+
+    if (!!(flags & SharedMemoryRegionFlags::Lock)) {
+        #if BOOST_OS_MACOS || BOOST_OS_LINUX
+            if (mlock(data, num_bytes) != 0) {
+                SP_LOG("WARNING: Couldn't lock shared memory region, consider increasing RLIMIT_MEMLOCK.");
+            }
+        #else
+            SP_LOG("WARNING: Locking shared memory regions is only supported on macOS and Linux.");
+        #endif
+    }
+}
+
+void SharedMemoryRegion::createMappedRegion()
+{
+    uint64_t num_bytes = getHeaderNumBytes() + num_bytes_;
+
+    #if BOOST_OS_WINDOWS
+        boost::interprocess::windows_shared_memory windows_shared_memory(boost::interprocess::create_only, id_.c_str(), boost::interprocess::read_write, num_bytes);
+        mapped_region_ = boost::interprocess::mapped_region(windows_shared_memory, boost::interprocess::read_write);
+    #elif BOOST_OS_MACOS || BOOST_OS_LINUX
+        boost::interprocess::shared_memory_object shared_memory_object(boost::interprocess::open_or_create, id_.c_str(), boost::interprocess::read_write);
+        shared_memory_object.truncate(num_bytes);
+        mapped_region_ = boost::interprocess::mapped_region(shared_memory_object, boost::interprocess::read_write);
+    #else
+        #error
+    #endif
+
+    SP_ASSERT(mapped_region_.get_address());
+
+    applyFlags(mapped_region_, flags_);
+}
+
+uint64_t SharedMemoryRegion::getHeaderNumBytes() const
+{
+    return !!(flags_ & SharedMemoryRegionFlags::Growable) ? sizeof(SharedMemoryRegionHeader) : 0;
+}
+
 uint64_t SharedMemoryRegion::getUniqueId()
 {
     static uint64_t id = 0;
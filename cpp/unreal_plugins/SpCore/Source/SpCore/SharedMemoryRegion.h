@@ -4,11 +4,13 @@
 
 #pragma once
 
-#include <stddef.h> // uint64_t
+#include <stddef.h> // size_t
+#include <stdint.h> // uint64_t
 
 #include <string>
 
 #include "SpCore/Boost.h"
+#include "SpCore/Std.h"
 
 struct SharedMemoryView
 {
@@ -17,21 +19,68 @@ struct SharedMemoryView
     void* data_ = nullptr;
 };
 
+// These flags control how the pages backing a shared memory region are allocated. HugePages requests transparent
+// huge pages on Linux and silently falls back to regular pages if they are unavailable. Prefault touches every page
+// up front, so the first write into the region doesn't page-fault through the entire region. Lock pins the region
+// in physical memory on macOS and Linux, and is subject to RLIMIT_MEMLOCK. Growable reserves a
+// SharedMemoryRegionHeader at the start of the region, and is required to call SharedMemoryRegion::resize(...).
+enum class SharedMemoryRegionFlags : uint8_t
+{
+    None      = 0,
+    HugePages = 1 << 0,
+    Prefault  = 1 << 1,
+    Lock      = 1 << 2,
+    Growable  = 1 << 3
+};
+SP_DECLARE_ENUM_FLAG_OPERATORS(SharedMemoryRegionFlags);
+
+// A growable region begins with this header. Other processes can compare generation_ to the value they observed
+// when they mapped the region to cheaply detect that the region has been resized and needs to be remapped. On
+// macOS and Linux, the region keeps its ID when it is resized. On Windows, named shared memory can't be resized,
+// so resizing moves the data into a new region, and id_ in the old region's header refers to the new region. The
+// layout of this header must be kept in sync with python/spear/shared_memory.py.
+struct SharedMemoryRegionHeader
+{
+    uint64_t generation_; // incremented every time the region is resized
+    uint64_t num_bytes_;  // number of bytes available to users of the region, excluding this header
+    char id_[48];         // null-terminated
+};
+static_assert(sizeof(SharedMemoryRegionHeader) == 64);
+
 class SPCORE_API SharedMemoryRegion
 {
 public:
     SharedMemoryRegion() = delete;
-    SharedMemoryRegion(int num_bytes);
-    SharedMemoryRegion(int num_bytes, uint64_t id); // useful if the caller wants to manage the allocation of uint64_t IDs to shared memory regions
+    SharedMemoryRegion(size_t num_bytes, SharedMemoryRegionFlags flags = SharedMemoryRegionFlags::None);
+    SharedMemoryRegion(size_t num_bytes, uint64_t id, SharedMemoryRegionFlags flags = SharedMemoryRegionFlags::None); // useful if the caller wants to manage the allocation of uint64_t IDs to shared memory regions
     ~SharedMemoryRegion();
 
+    // For growable regions, the view excludes the header.
     SharedMemoryView getView();
 
-private:
+    // Preserves the contents of the region up to the smaller of the old and new sizes. On macOS and Linux, the
+    // region can only grow, i.e., num_bytes must not be smaller than the current size. The address of the region
+    // may change, so any views obtained via getView() must be obtained again after calling this function.
+    void resize(size_t num_bytes);
+
+    // Flags that apply to all regions, read from SP_CORE.SHARED_MEMORY.* if the config system is initialized. These
+    // are combined with the flags passed to the constructor.
+    static SharedMemoryRegionFlags getGlobalFlags();
+
+    // Useful for systems that create their own mapped regions rather than using SharedMemoryRegion directly.
+    static void applyFlags(boost::interprocess::mapped_region& mapped_region, SharedMemoryRegionFlags flags);
+
+    // Also useful for systems that create their own mapped regions, so their names don't collide with each other or
+    // with other regions. The string includes a leading slash on macOS and Linux.
     static uint64_t getUniqueId();
     static std::string getUniqueIdString(uint64_t id);
 
+private:
+    void createMappedRegion();
+    uint64_t getHeaderNumBytes() const;
+
     std::string id_;
     uint64_t num_bytes_ = 0;
+    SharedMemoryRegionFlags flags_ = SharedMemoryRegionFlags::None;
     boost::interprocess::mapped_region mapped_region_;
 };
@@ -0,0 +1,67 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpCore/SharedMemoryTripleBuffer.h"
+
+#include <stdint.h> // uint8_t, uint32_t, uint64_t
+#include <string.h> // memset
+
+#include <atomic>   // std::atomic_ref, std::atomic_thread_fence, std::memory_order
+
+#include "SpCore/Assert.h"
+
+uint64_t SharedMemoryTripleBuffer::getNumBytes(uint64_t slot_num_bytes)
+{
+    uint64_t slot_offset = (sizeof(SharedMemoryTripleBufferHeader) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    uint64_t slot_stride = (slot_num_bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    return slot_offset + NUM_SLOTS*slot_stride;
+}
+
+void SharedMemoryTripleBuffer::initialize(void* data, uint64_t slot_num_bytes)
+{
+    SP_ASSERT(data);
+    SP_ASSERT(slot_num_bytes > 0);
+
+    SharedMemoryTripleBufferHeader* header = static_cast<SharedMemoryTripleBufferHeader*>(data);
+    memset(header, 0, sizeof(SharedMemoryTripleBufferHeader));
+    header->latest_slot_ = 0;
+    header->reader_slot_ = 0;
+    header->writer_slot_ = 1;
+    header->num_slots_ = NUM_SLOTS;
+    header->slot_offset_ = (sizeof(SharedMemoryTripleBufferHeader) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    header->slot_stride_ = (slot_num_bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+void* SharedMemoryTripleBuffer::beginWrite(void* data)
+{
+    SP_ASSERT(data);
+    SharedMemoryTripleBufferHeader* header = static_cast<SharedMemoryTripleBufferHeader*>(data);
+
+    // With three slots, there is always at least one slot that is neither the latest slot nor the reader's slot.
+    uint32_t latest_slot = header->latest_slot_;
+    uint32_t reader_slot = std::atomic_ref<uint32_t>(header->reader_slot_).load(std::memory_order_acquire);
+    uint32_t writer_slot = 0;
+    for (; writer_slot < NUM_SLOTS; writer_slot++) {
+        if (writer_slot != latest_slot && writer_slot != reader_slot) {
+            break;
+        }
+    }
+    SP_ASSERT(writer_slot < NUM_SLOTS);
+
+    header->writer_slot_ = writer_slot;
+    return static_cast<uint8_t*>(data) + header->slot_offset_ + writer_slot*header->slot_stride_;
+}
+
+void SharedMemoryTripleBuffer::endWrite(void* data)
+{
+    SP_ASSERT(data);
+    SharedMemoryTripleBufferHeader* header = static_cast<SharedMemoryTripleBufferHeader*>(data);
+    std::atomic_ref<uint64_t> sequence(header->sequence_);
+
+    sequence.fetch_add(1, std::memory_order_acq_rel); // odd, update in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    header->latest_slot_ = header->writer_slot_;
+    header->frame_index_++;
+    sequence.fetch_add(1, std::memory_order_release); // even, update complete
+}
@@ -0,0 +1,49 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint32_t, uint64_t
+
+//
+// A triple buffer lets a producer write the next frame into shared memory while a consumer is still reading
+// the previous frame. The shared memory resource begins with a SharedMemoryTripleBufferHeader, followed by
+// three equally sized slots. The producer always writes into a slot that is neither the most recently
+// published slot nor the slot that the consumer has claimed, and then publishes it by updating latest_slot_
+// under a seqlock. The consumer reads sequence_, reads latest_slot_, writes reader_slot_, and then re-reads
+// sequence_ to confirm that nothing was published in the meantime. The layout of the header must be kept in
+// sync with python/spear/env.py.
+//
+
+struct SharedMemoryTripleBufferHeader
+{
+    uint64_t sequence_;    // seqlock, odd while latest_slot_ and frame_index_ are being updated
+    uint64_t frame_index_; // number of frames that have been published
+    uint32_t latest_slot_; // most recently published slot
+    uint32_t reader_slot_; // written by the consumer to claim a slot
+    uint32_t writer_slot_; // slot currently being written by the producer
+    uint32_t num_slots_;
+    uint64_t slot_offset_; // offset of the first slot relative to the start of the shared memory resource
+    uint64_t slot_stride_; // distance in bytes between consecutive slots
+};
+static_assert(sizeof(SharedMemoryTripleBufferHeader) == 48);
+
+class SPCORE_API SharedMemoryTripleBuffer
+{
+public:
+    SharedMemoryTripleBuffer() = delete;
+    ~SharedMemoryTripleBuffer() = delete;
+
+    static constexpr uint32_t NUM_SLOTS = 3;
+    static constexpr uint64_t ALIGNMENT = 64;
+
+    // total number of bytes needed to store a header and three slots of slot_num_bytes each
+    static uint64_t getNumBytes(uint64_t slot_num_bytes);
+
+    static void initialize(void* data, uint64_t slot_num_bytes);
+
+    // beginWrite(...) returns a pointer to the slot that should be written, and endWrite(...) publishes it
+    static void* beginWrite(void* data);
+    static void endWrite(void* data);
+};
@@ -36,7 +36,7 @@ public class SpModuleRules : ModuleRules
         bEnableUndefinedIdentifierWarnings = false;
 
         PublicDependencyModuleNames.AddRange(new string[] {
-            "ChaosVehiclesCore", "Core", "CoreUObject", "Engine", "InputCore", "Json", "JsonUtilities", "NavigationSystem", "PhysicsCore", "RenderCore", "RHI",
+            "ChaosVehiclesCore", "Core", "CoreUObject", "Engine", "ImageWrapper", "InputCore", "Json", "JsonUtilities", "NavigationSystem", "Navmesh", "PhysicsCore", "RenderCore", "RHI",
             "XmlParser"});
         PrivateDependencyModuleNames.AddRange(new string[] {});
 
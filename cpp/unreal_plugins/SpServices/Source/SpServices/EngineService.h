@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <stdint.h> // uint8_t
+#include <stdint.h> // uint8_t, uint64_t
 
 #include <atomic>
 #include <future> // std::promise, std::future
@@ -156,6 +156,11 @@ public:
         entry_point_binder_->bind(service_name + "." + func_name, WorkQueue::wrapFuncToExecuteInWorkQueueBlocking(work_queue_, func));
     }
 
+    // The number of frames that have been started by calls to begin_tick, and the state of the current frame.
+    // Useful for services that need to know when, relative to begin_tick and end_tick, an entry point was called.
+    uint64_t getFrameIndex() const { return frame_index_; }
+    FrameState getFrameState() const { return frame_state_; }
+
     void close()
     {
         // We need to lock frame_state_mutex_ here, because the RPC worker thread might call begin_tick() any
@@ -195,6 +200,7 @@ private:
             // because if frame_state_ == FrameState::RequestPreTick, then we know the RPC worker thread is
             // currently waiting in begin_tick() at a point where it will not attempt to make any further
             // modifications to frame_state_.
+            frame_index_++;
             frame_state_ = FrameState::ExecutingPreTick;
             frame_state_executing_pre_tick_promise_.set_value();
 
@@ -231,6 +237,7 @@ private:
     FDelegateHandle end_frame_handle_;
 
     std::atomic<FrameState> frame_state_ = FrameState::Invalid;
+    std::atomic<uint64_t> frame_index_ = 0;
     std::mutex frame_state_mutex_;
 
     std::promise<void> frame_state_idle_promise_;
@@ -0,0 +1,171 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/ActionLog.h"
+
+#include <stdint.h> // uint8_t, uint64_t
+#include <string.h> // memcmp, memcpy
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SpCore/Assert.h"
+#include "SpCore/Boost.h"
+#include "SpCore/Log.h"
+#include "SpCore/Std.h"
+
+//
+// ActionLogWriter
+//
+
+ActionLogWriter::ActionLogWriter(const std::string& file)
+{
+    SP_LOG("Opening action log for writing: ", file);
+
+    stream_.open(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    SP_ASSERT(stream_.is_open());
+
+    ActionLogHeader header = {{'S', 'P', 'A', 'C', 'T', 'L', 'O', 'G'}, VERSION, 0};
+    stream_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    SP_ASSERT(stream_.good());
+}
+
+ActionLogWriter::~ActionLogWriter()
+{
+    SP_ASSERT(!stream_.is_open());
+}
+
+void ActionLogWriter::writeRecord(ActionLogRecordType type, ActionLogRecordPhase phase, uint64_t frame_index, const std::map<std::string, std::vector<uint8_t>>& arrays)
+{
+    SP_ASSERT(stream_.is_open());
+
+    ActionLogRecordHeader record_header;
+    record_header.type_ = type;
+    record_header.phase_ = phase;
+    record_header.frame_index_ = frame_index;
+    record_header.num_bytes_ = 0;
+    if (!arrays.empty()) {
+        record_header.num_bytes_ = sizeof(uint64_t);
+        for (auto& [name, data] : arrays) {
+            record_header.num_bytes_ += sizeof(uint64_t) + name.size() + sizeof(uint64_t) + data.size();
+        }
+    }
+    stream_.write(reinterpret_cast<const char*>(&record_header), sizeof(record_header));
+
+    if (!arrays.empty()) {
+        uint64_t num_arrays = arrays.size();
+        stream_.write(reinterpret_cast<const char*>(&num_arrays), sizeof(num_arrays));
+        for (auto& [name, data] : arrays) {
+            uint64_t name_num_bytes = name.size();
+            uint64_t data_num_bytes = data.size();
+            stream_.write(reinterpret_cast<const char*>(&name_num_bytes), sizeof(name_num_bytes));
+            stream_.write(name.data(), name_num_bytes);
+            stream_.write(reinterpret_cast<const char*>(&data_num_bytes), sizeof(data_num_bytes));
+            stream_.write(reinterpret_cast<const char*>(data.data()), data_num_bytes);
+        }
+    }
+
+    SP_ASSERT(stream_.good());
+}
+
+void ActionLogWriter::close(uint64_t frame_index)
+{
+    writeRecord(ActionLogRecordType::End, ActionLogRecordPhase::PostTick, frame_index);
+    stream_.close();
+}
+
+//
+// ActionLogReader
+//
+
+ActionLogReader::ActionLogReader(const std::string& file)
+{
+    SP_LOG("Mapping action log: ", file);
+
+    file_mapping_ = boost::interprocess::file_mapping(file.c_str(), boost::interprocess::read_only);
+    mapped_region_ = boost::interprocess::mapped_region(file_mapping_, boost::interprocess::read_only);
+    SP_ASSERT(mapped_region_.get_size() >= sizeof(ActionLogHeader));
+
+    data_ = static_cast<const uint8_t*>(mapped_region_.get_address());
+    num_bytes_ = mapped_region_.get_size();
+
+    const ActionLogHeader* header = reinterpret_cast<const ActionLogHeader*>(data_);
+    SP_ASSERT(memcmp(header->magic_, "SPACTLOG", sizeof(header->magic_)) == 0);
+    SP_ASSERT(header->version_ == ActionLogWriter::VERSION);
+
+    offset_ = sizeof(ActionLogHeader);
+}
+
+bool ActionLogReader::isAtEnd() const
+{
+    return offset_ + sizeof(ActionLogRecordHeader) > num_bytes_ || getRecordHeader().type_ == ActionLogRecordType::End;
+}
+
+ActionLogRecordHeader ActionLogReader::getRecordHeader() const
+{
+    // payloads aren't padded, so records aren't necessarily aligned, and we read them with memcpy to avoid unaligned loads
+    SP_ASSERT(offset_ + sizeof(ActionLogRecordHeader) <= num_bytes_);
+    ActionLogRecordHeader record_header;
+    memcpy(&record_header, data_ + offset_, sizeof(record_header));
+    return record_header;
+}
+
+std::map<std::string, std::vector<uint8_t>> ActionLogReader::getRecordArrays() const
+{
+    // getRecordHeader() checks that the header fits in the file, and we compare sizes against the number of bytes
+    // remaining rather than adding them to offsets, so a corrupt size can't overflow and pass the check
+    ActionLogRecordHeader record_header = getRecordHeader();
+    SP_ASSERT(record_header.num_bytes_ <= num_bytes_ - offset_ - sizeof(ActionLogRecordHeader));
+
+    std::map<std::string, std::vector<uint8_t>> arrays;
+    if (record_header.num_bytes_ == 0) {
+        return arrays;
+    }
+
+    const uint8_t* ptr = data_ + offset_ + sizeof(ActionLogRecordHeader);
+    uint64_t num_bytes_remaining = record_header.num_bytes_;
+
+    uint64_t num_arrays = 0;
+    SP_ASSERT(sizeof(num_arrays) <= num_bytes_remaining);
+    memcpy(&num_arrays, ptr, sizeof(num_arrays));
+    ptr += sizeof(num_arrays);
+    num_bytes_remaining -= sizeof(num_arrays);
+
+    for (uint64_t i = 0; i < num_arrays; i++) {
+        uint64_t name_num_bytes = 0;
+        SP_ASSERT(sizeof(name_num_bytes) <= num_bytes_remaining);
+        memcpy(&name_num_bytes, ptr, sizeof(name_num_bytes));
+        ptr += sizeof(name_num_bytes);
+        num_bytes_remaining -= sizeof(name_num_bytes);
+
+        SP_ASSERT(name_num_bytes <= num_bytes_remaining);
+        std::string name(reinterpret_cast<const char*>(ptr), name_num_bytes);
+        ptr += name_num_bytes;
+        num_bytes_remaining -= name_num_bytes;
+
+        uint64_t data_num_bytes = 0;
+        SP_ASSERT(sizeof(data_num_bytes) <= num_bytes_remaining);
+        memcpy(&data_num_bytes, ptr, sizeof(data_num_bytes));
+        ptr += sizeof(data_num_bytes);
+        num_bytes_remaining -= sizeof(data_num_bytes);
+
+        SP_ASSERT(data_num_bytes <= num_bytes_remaining);
+        Std::insert(arrays, name, std::vector<uint8_t>(ptr, ptr + data_num_bytes));
+        ptr += data_num_bytes;
+        num_bytes_remaining -= data_num_bytes;
+    }
+    SP_ASSERT(num_bytes_remaining == 0);
+
+    return arrays;
+}
+
+void ActionLogReader::next()
+{
+    SP_ASSERT(!isAtEnd());
+    ActionLogRecordHeader record_header = getRecordHeader();
+    SP_ASSERT(record_header.num_bytes_ <= num_bytes_ - offset_ - sizeof(ActionLogRecordHeader));
+    offset_ += sizeof(ActionLogRecordHeader) + record_header.num_bytes_;
+}
@@ -0,0 +1,108 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint8_t, uint32_t, uint64_t
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SpCore/Boost.h"
+
+//
+// An action log is a binary file that records the calls made to LegacyService's stepping and reset entry points,
+// so a run can be replayed inside the engine without a Python client. The file begins with an ActionLogHeader,
+// followed by a sequence of records. Each record is an ActionLogRecordHeader followed by num_bytes_ bytes of
+// payload. A payload is a serialized map of named byte arrays, stored as a uint64_t number of arrays, followed
+// by (uint64_t name size, name, uint64_t data size, data) for each array. The first record in a log written by
+// LegacyService::startRecording(...) has type Start, and stores the reset state of each task (see Task.h), keyed
+// by agent index. Every frame in the log begins with a record of type Tick, even if the client didn't call any entry
+// points during the frame, so a replay ticks the engine exactly as often as the recording did. The last record in a
+// complete log has type End. All values are little-endian.
+//
+// frame_index_ counts the frames that were started by calls to engine_service.begin_tick, relative to the frame
+// where recording started, and phase_ records whether the call was made before (i.e., between begin_tick and
+// tick) or after (i.e., between tick and end_tick) the engine advanced the world.
+//
+
+enum class ActionLogRecordType : uint32_t
+{
+    End                      = 0,
+    ApplyAction              = 1,
+    GetObservation           = 2,
+    ResetAgent               = 3,
+    ResetTask                = 4,
+    ApplyVectorizedAction    = 5,
+    GetVectorizedObservation = 6,
+    AutoResetVectorized      = 7,
+    ResetVectorized          = 8,
+    Start                    = 9,
+    Tick                     = 10
+};
+
+enum class ActionLogRecordPhase : uint32_t
+{
+    PreTick  = 0,
+    PostTick = 1
+};
+
+struct ActionLogHeader
+{
+    char magic_[8]; // "SPACTLOG"
+    uint32_t version_;
+    uint32_t reserved_;
+};
+static_assert(sizeof(ActionLogHeader) == 16);
+
+struct ActionLogRecordHeader
+{
+    ActionLogRecordType type_;
+    ActionLogRecordPhase phase_;
+    uint64_t frame_index_;
+    uint64_t num_bytes_; // number of payload bytes following this header
+};
+static_assert(sizeof(ActionLogRecordHeader) == 24);
+
+class ActionLogWriter
+{
+public:
+    ActionLogWriter() = delete;
+    ActionLogWriter(const std::string& file);
+    ~ActionLogWriter();
+
+    void writeRecord(ActionLogRecordType type, ActionLogRecordPhase phase, uint64_t frame_index, const std::map<std::string, std::vector<uint8_t>>& arrays = {});
+
+    // writes an End record and closes the file, must be called before the writer is destroyed
+    void close(uint64_t frame_index);
+
+    static constexpr uint32_t VERSION = 3;
+
+private:
+    std::ofstream stream_;
+};
+
+class ActionLogReader
+{
+public:
+    ActionLogReader() = delete;
+    ActionLogReader(const std::string& file);
+
+    // returns true once the reader has reached the End record, or the end of the file if the log is incomplete
+    bool isAtEnd() const;
+
+    ActionLogRecordHeader getRecordHeader() const;
+    std::map<std::string, std::vector<uint8_t>> getRecordArrays() const;
+    void next();
+
+private:
+    boost::interprocess::file_mapping file_mapping_;
+    boost::interprocess::mapped_region mapped_region_;
+
+    const uint8_t* data_ = nullptr;
+    uint64_t num_bytes_ = 0;
+    uint64_t offset_ = 0; // offset of the current record relative to the start of the file
+};
@@ -22,7 +22,7 @@ public:
     // An Agent class must spawn new objects in the constructor if they are intended to be
     // findable by other classes. An Agent class must not attempt to find object references
     // in the constructor, because these objects might not be spawned yet. Use findObjectReferences(...)
-    // instead.
+    // instead. Agent classes are constructed with a UWorld* and an agent index, see AgentInstance.h.
     Agent() = default;
     virtual ~Agent() = default;
 
@@ -36,9 +36,12 @@ public:
     virtual void applyAction(const std::map<std::string, std::vector<uint8_t>>& action) = 0;
     virtual std::map<std::string, std::vector<uint8_t>> getObservation() const = 0;
     virtual std::map<std::string, std::vector<uint8_t>> getStepInfo() const = 0;
+
+    // Sensors that are configured to update on demand only update on the frame after they are requested here.
+    virtual void requestSensorUpdates(const std::vector<std::string>& sensor_names) = 0;
     
     virtual void reset() = 0;
     virtual bool isReady() const = 0;
 
-    inline static auto s_class_registrar_ = ClassRegistrationUtils::getClassRegistrar<Agent, UWorld*>();
+    inline static auto s_class_registrar_ = ClassRegistrationUtils::getClassRegistrar<Agent, UWorld*, int>();
 };
@@ -0,0 +1,30 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/AgentInstance.h"
+
+#include <string> // std::to_string
+
+#include <Math/Vector.h>
+
+#include "SpCore/Assert.h"
+#include "SpCore/Config.h"
+
+std::string AgentInstance::getName(const std::string& name, int agent_index)
+{
+    SP_ASSERT(agent_index >= 0);
+    return agent_index == 0 ? name : name + "_" + std::to_string(agent_index);
+}
+
+FVector AgentInstance::getOffset(int agent_index)
+{
+    SP_ASSERT(agent_index >= 0);
+    if (agent_index == 0 || !Config::isInitialized()) {
+        return FVector::ZeroVector;
+    }
+    return agent_index * FVector(
+        Config::get<double>("SP_SERVICES.LEGACY_SERVICE.AGENT_SPACING_X"),
+        Config::get<double>("SP_SERVICES.LEGACY_SERVICE.AGENT_SPACING_Y"),
+        Config::get<double>("SP_SERVICES.LEGACY_SERVICE.AGENT_SPACING_Z"));
+}
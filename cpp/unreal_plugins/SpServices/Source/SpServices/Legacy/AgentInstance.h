@@ -0,0 +1,26 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <string>
+
+#include <Math/Vector.h>
+
+// If SP_SERVICES.LEGACY_SERVICE.NUM_AGENTS is greater than 1, LegacyService creates one Agent and one Task per agent
+// index in the same world. Agents and tasks use these functions to keep their instances apart: every actor they spawn
+// or find by name uses getName(...), and every location they set or return is relative to getOffset(...). Agent 0
+// behaves exactly like a non-vectorized agent.
+class AgentInstance
+{
+public:
+    AgentInstance() = delete;
+    ~AgentInstance() = delete;
+
+    // returns name for agent 0, and name + "_" + agent_index for all other agents
+    static std::string getName(const std::string& name, int agent_index);
+
+    // returns agent_index times (AGENT_SPACING_X, AGENT_SPACING_Y, AGENT_SPACING_Z)
+    static FVector getOffset(int agent_index);
+};
@@ -26,12 +26,15 @@
 #include "SpCore/Std.h"
 #include "SpCore/Unreal.h"
 
+#include "SpServices/Legacy/AgentInstance.h"
 #include "SpServices/Legacy/CameraSensor.h"
 
 struct FHitResult;
 
-CameraAgent::CameraAgent(UWorld* world)
+CameraAgent::CameraAgent(UWorld* world, int agent_index)
 {
+    agent_index_ = agent_index;
+
     FVector spawn_location = FVector::ZeroVector;
     FRotator spawn_rotation = FRotator::ZeroRotator;
     std::string spawn_mode = Config::get<std::string>("SP_SERVICES.LEGACY.CAMERA_AGENT.SPAWN_MODE");
@@ -52,8 +55,10 @@ CameraAgent::CameraAgent(UWorld* world)
     } else {
         SP_ASSERT(false);
     }
+    spawn_location += AgentInstance::getOffset(agent_index_);
+
     FActorSpawnParameters actor_spawn_parameters;
-    actor_spawn_parameters.Name = Unreal::toFName(Config::get<std::string>("SP_SERVICES.LEGACY.CAMERA_AGENT.CAMERA_ACTOR_NAME"));
+    actor_spawn_parameters.Name = Unreal::toFName(AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.CAMERA_AGENT.CAMERA_ACTOR_NAME"), agent_index_));
     actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
     camera_actor_ = world->SpawnActor<ACameraActor>(spawn_location, spawn_rotation, actor_spawn_parameters);
     SP_ASSERT(camera_actor_);
@@ -145,8 +150,8 @@ void CameraAgent::applyAction(const std::map<std::string, std::vector<uint8_t>>&
         std::span<const double> action_component_data = Std::reinterpretAsSpanOf<const double>(action.at("set_location"));
         bool sweep = false;
         FHitResult* hit_result = nullptr;
-        camera_actor_->SetActorLocation(
-            {Std::at(action_component_data, 0), Std::at(action_component_data, 1), Std::at(action_component_data, 2)}, sweep, hit_result, ETeleportType::ResetPhysics);
+        FVector location = FVector(Std::at(action_component_data, 0), Std::at(action_component_data, 1), Std::at(action_component_data, 2)) + AgentInstance::getOffset(agent_index_);
+        camera_actor_->SetActorLocation(location, sweep, hit_result, ETeleportType::ResetPhysics);
     }
 
     if (Std::contains(action_components, "set_rotation")) {
@@ -172,6 +177,15 @@ std::map<std::string, std::vector<uint8_t>> CameraAgent::getStepInfo() const
     return {};
 }
 
+void CameraAgent::requestSensorUpdates(const std::vector<std::string>& sensor_names)
+{
+    auto observation_components = Config::get<std::vector<std::string>>("SP_SERVICES.LEGACY.CAMERA_AGENT.OBSERVATION_COMPONENTS");
+
+    if (Std::contains(observation_components, "camera") && Std::contains(sensor_names, "camera")) {
+        camera_sensor_->requestUpdate();
+    }
+}
+
 void CameraAgent::reset() {}
 
 bool CameraAgent::isReady() const
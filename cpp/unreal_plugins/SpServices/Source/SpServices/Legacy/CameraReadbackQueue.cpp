@@ -0,0 +1,146 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/CameraReadbackQueue.h"
+
+#include <stdint.h> // int64_t, uint8_t, uint64_t
+#include <string.h> // memcpy, memset
+
+#include <memory>   // std::make_unique
+#include <string>
+
+#include <CoreGlobals.h>           // GFrameCounter
+#include <Engine/TextureRenderTarget2D.h>
+#include <HAL/Platform.h>          // int32
+#include <Misc/App.h>              // FApp
+#include <RenderCommandFence.h>
+#include <RenderingThread.h>       // ENQUEUE_RENDER_COMMAND
+#include <RHICommandList.h>        // FRHICommandListImmediate
+#include <RHIGPUReadback.h>        // FRHIGPUTextureReadback
+#include <TextureResource.h>       // FTextureRenderTargetResource
+
+#include "SpCore/Assert.h"
+#include "SpCore/Std.h"
+#include "SpCore/Unreal.h"
+
+CameraReadbackQueue::CameraReadbackQueue(int latency, int width, int height, int num_bytes_per_pixel)
+{
+    SP_ASSERT(latency > 0);
+    SP_ASSERT(width > 0);
+    SP_ASSERT(height > 0);
+    SP_ASSERT(num_bytes_per_pixel > 0);
+
+    latency_ = static_cast<size_t>(latency);
+    width_ = width;
+    height_ = height;
+    num_bytes_per_pixel_ = num_bytes_per_pixel;
+    can_render_ = FApp::CanEverRender();
+
+    // We need one more readback than the latency, because we enqueue a new copy before reading the oldest one.
+    for (size_t i = 0; i < latency_ + 1; i++) {
+        readbacks_.push_back(std::make_unique<FRHIGPUTextureReadback>(Unreal::toFName("camera_readback_queue_" + Std::toString(i))));
+    }
+}
+
+CameraReadbackQueue::~CameraReadbackQueue()
+{
+    // make sure the render thread is no longer referencing our readbacks before we destroy them
+    FlushRenderingCommands();
+}
+
+void CameraReadbackQueue::enqueueCopy(UTextureRenderTarget2D* texture_render_target_2d)
+{
+    SP_ASSERT(texture_render_target_2d);
+    SP_ASSERT(pending_readbacks_.size() < readbacks_.size());
+
+    PendingReadback pending_readback;
+    pending_readback.frame_index_ = static_cast<int64_t>(GFrameCounter);
+    pending_readback.readback_index_ = next_readback_index_;
+    next_readback_index_ = (next_readback_index_ + 1) % readbacks_.size();
+
+    if (can_render_) {
+        FTextureRenderTargetResource* texture_render_target_resource = texture_render_target_2d->GameThread_GetRenderTargetResource();
+        SP_ASSERT(texture_render_target_resource);
+        FRHIGPUTextureReadback* readback = readbacks_.at(pending_readback.readback_index_).get();
+
+        ENQUEUE_RENDER_COMMAND(SpCameraReadbackQueueEnqueueCopy)(
+            [readback, texture_render_target_resource](FRHICommandListImmediate& rhi_command_list) -> void {
+                readback->EnqueueCopy(rhi_command_list, texture_render_target_resource->GetRenderTargetTexture());
+            });
+    }
+
+    pending_readbacks_.push_back(pending_readback);
+}
+
+int64_t CameraReadbackQueue::read(void* dest_ptr)
+{
+    SP_ASSERT(dest_ptr);
+
+    if (pending_readbacks_.empty()) {
+        return -1;
+    }
+
+    // If the oldest copy is too recent, the GPU might not have finished it yet, so we return instead of waiting.
+    // But if every readback is in use, we need to read the oldest one, so the next call to enqueueCopy(...) has a
+    // readback to copy into. This happens if we're called more than once per frame.
+    uint64_t age = GFrameCounter - static_cast<uint64_t>(pending_readbacks_.front().frame_index_);
+    if (age < latency_ && pending_readbacks_.size() < readbacks_.size()) {
+        return -1;
+    }
+
+    return readOldest(dest_ptr);
+}
+
+int64_t CameraReadbackQueue::readOldest(void* dest_ptr)
+{
+    SP_ASSERT(dest_ptr);
+    SP_ASSERT(!pending_readbacks_.empty());
+
+    PendingReadback pending_readback = pending_readbacks_.front();
+    pending_readbacks_.pop_front();
+
+    uint64_t row_num_bytes = static_cast<uint64_t>(width_) * num_bytes_per_pixel_;
+
+    if (!can_render_) {
+        memset(dest_ptr, 0, row_num_bytes * height_);
+        return pending_readback.frame_index_;
+    }
+
+    // We lock the readback on the render thread, and wait for the render thread to finish copying the data. The
+    // copy was usually enqueued at least latency_ frames ago, so the GPU has already finished it, and we only wait
+    // for the render thread to reach our command, not for the GPU. We only wait for the GPU if it's more than
+    // latency_ frames behind, which is no worse than a synchronous readback.
+    FRHIGPUTextureReadback* readback = readbacks_.at(pending_readback.readback_index_).get();
+    int height = height_;
+    int num_bytes_per_pixel = num_bytes_per_pixel_;
+
+    ENQUEUE_RENDER_COMMAND(SpCameraReadbackQueueRead)(
+        [readback, dest_ptr, height, num_bytes_per_pixel, row_num_bytes](FRHICommandListImmediate& rhi_command_list) -> void {
+            if (!readback->IsReady()) {
+                rhi_command_list.BlockUntilGPUIdle();
+            }
+
+            int32 row_pitch_in_pixels = 0;
+            const uint8_t* src_ptr = static_cast<const uint8_t*>(readback->Lock(row_pitch_in_pixels));
+            SP_ASSERT(src_ptr);
+
+            uint64_t src_row_num_bytes = static_cast<uint64_t>(row_pitch_in_pixels) * num_bytes_per_pixel;
+            for (int i = 0; i < height; i++) {
+                memcpy(static_cast<uint8_t*>(dest_ptr) + i*row_num_bytes, src_ptr + i*src_row_num_bytes, row_num_bytes);
+            }
+
+            readback->Unlock();
+        });
+
+    FRenderCommandFence render_command_fence;
+    render_command_fence.BeginFence();
+    render_command_fence.Wait();
+
+    return pending_readback.frame_index_;
+}
+
+void CameraReadbackQueue::discardPendingCopies()
+{
+    pending_readbacks_.clear();
+}
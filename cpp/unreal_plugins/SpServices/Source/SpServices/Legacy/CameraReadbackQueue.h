@@ -0,0 +1,61 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stddef.h> // size_t
+#include <stdint.h> // int64_t, uint64_t
+
+#include <deque>
+#include <memory>   // std::unique_ptr
+#include <vector>
+
+class FRHIGPUTextureReadback;
+class UTextureRenderTarget2D;
+
+// A CameraReadbackQueue copies a render target into CPU-accessible memory without stalling the game thread
+// until the GPU has finished rendering. Each call to enqueueCopy(...) schedules an asynchronous GPU copy, and
+// each call to read(...) returns a copy once it was scheduled at least latency engine frames earlier, by which
+// time the GPU has usually finished it. Copies are tagged with the value of GFrameCounter when they were
+// scheduled. If the engine is running without a renderer (e.g., with -nullrhi), no GPU work is scheduled and
+// read(...) writes zeros instead, so the frame tagging logic behaves identically with and without a GPU.
+class CameraReadbackQueue
+{
+public:
+    CameraReadbackQueue() = delete;
+    CameraReadbackQueue(int latency, int width, int height, int num_bytes_per_pixel);
+    ~CameraReadbackQueue();
+
+    // Called once per frame from the game thread.
+    void enqueueCopy(UTextureRenderTarget2D* texture_render_target_2d);
+
+    // Writes the oldest pending copy into dest_ptr and returns its frame index if it was enqueued at least latency
+    // frames ago, or if every readback is in use. Otherwise leaves dest_ptr unchanged and returns -1 without waiting.
+    int64_t read(void* dest_ptr);
+
+    // Writes the oldest pending copy into dest_ptr and returns its frame index regardless of when it was enqueued,
+    // waiting for the GPU if necessary. Useful for callers that capture several times within a single frame, e.g.,
+    // TrajectoryRenderer, because GFrameCounter doesn't advance between their copies.
+    int64_t readOldest(void* dest_ptr);
+
+    // Discards all pending copies without reading them.
+    void discardPendingCopies();
+
+private:
+    struct PendingReadback
+    {
+        int64_t frame_index_ = -1; // value of GFrameCounter when the copy was enqueued
+        int readback_index_ = -1;
+    };
+
+    size_t latency_ = 0;
+    int width_ = -1;
+    int height_ = -1;
+    int num_bytes_per_pixel_ = -1;
+    bool can_render_ = false;
+
+    std::vector<std::unique_ptr<FRHIGPUTextureReadback>> readbacks_;
+    std::deque<PendingReadback> pending_readbacks_;
+    int next_readback_index_ = 0;
+};
@@ -4,17 +4,20 @@
 
 #include "SpServices/Legacy/CameraSensor.h"
 
-#include <stdint.h> // uint8_t
+#include <stdint.h> // int32_t, uint8_t, uint16_t, uint32_t, uint64_t
 
 #include <limits>  // std::numeric_limits
 #include <map>
+#include <memory>  // std::make_unique
 #include <string>
 #include <utility> // std::move
 #include <vector>
 
 #include <Camera/CameraComponent.h>
 #include <Components/SceneCaptureComponent2D.h>
+#include <Engine/EngineBaseTypes.h>       // ELevelTick, ETickingGroup
 #include <Engine/TextureRenderTarget2D.h> // ETextureRenderTargetFormat
+#include <Engine/World.h>
 #include <GameFramework/Actor.h>
 #include <Materials/MaterialInstanceDynamic.h>
 #include <UObject/UObjectGlobals.h>       // LoadObject, NewObject
@@ -23,9 +26,19 @@
 #include "SpCore/Assert.h"
 #include "SpCore/Boost.h"
 #include "SpCore/Config.h"
+#include "SpCore/SharedMemoryRegion.h"
+#include "SpCore/SharedMemoryTripleBuffer.h"
 #include "SpCore/Std.h"
 #include "SpCore/Unreal.h"
 
+#include "SpServices/Legacy/CameraReadbackQueue.h"
+#include "SpServices/Legacy/DerivedOutputs.h"
+#include "SpServices/Legacy/RenderPassCompaction.h"
+#include "SpServices/Legacy/SensorSchedule.h"
+#include "SpServices/Legacy/StandaloneComponent.h"
+#include "SpServices/Legacy/TickComponent.h"
+
+struct FActorComponentTickFunction;
 struct FColor;
 struct FLinearColor;
 
@@ -73,20 +86,92 @@ const std::map<std::string, DataType> RENDER_PASS_CHANNEL_DATATYPE = {
     {"normal",       DataType::Float32},
     {"segmentation", DataType::UInteger8}};
 
+// Each render pass can optionally be compacted into a smaller output format on the CPU after it has been read back,
+// by appending ":<format>" to its name in CAMERA.RENDER_PASSES, e.g., "depth:r16f". The first format for each render
+// pass is the default, and leaves the 4-channel data returned by ReadPixels unchanged.
+const std::map<std::string, std::vector<std::string>> RENDER_PASS_OUTPUT_FORMATS = {
+    {"depth",        {"rgba32f", "r32f", "r16f"}},
+    {"final_color",  {"bgra8"}},
+    {"normal",       {"rgba32f", "rgb16f", "rg16f_octahedral"}},
+    {"segmentation", {"bgra8", "r16ui", "r32ui"}}};
+
+const std::map<std::string, int> OUTPUT_FORMAT_NUM_CHANNELS = {
+    {"bgra8",            4},
+    {"r16f",             1},
+    {"r16ui",            1},
+    {"r32f",             1},
+    {"r32ui",            1},
+    {"rg16f_octahedral", 2},
+    {"rgb16f",           3},
+    {"rgba32f",          4}};
+
+const std::map<std::string, DataType> OUTPUT_FORMAT_CHANNEL_DATATYPE = {
+    {"bgra8",            DataType::UInteger8},
+    {"r16f",             DataType::Float16},
+    {"r16ui",            DataType::UInteger16},
+    {"r32f",             DataType::Float32},
+    {"r32ui",            DataType::UInteger32},
+    {"rg16f_octahedral", DataType::Float16},
+    {"rgb16f",           DataType::Float16},
+    {"rgba32f",          DataType::Float32}};
+
+const std::map<std::string, int> OUTPUT_FORMAT_NUM_BYTES_PER_CHANNEL = {
+    {"bgra8",            1},
+    {"r16f",             2},
+    {"r16ui",            2},
+    {"r32f",             4},
+    {"r32ui",            4},
+    {"rg16f_octahedral", 2},
+    {"rgb16f",           2},
+    {"rgba32f",          4}};
+
+// segmentation ids span the full range of their output type, all other formats use RENDER_PASS_LOW and RENDER_PASS_HIGH
+const std::map<std::string, double> OUTPUT_FORMAT_HIGH = {
+    {"r16ui", std::numeric_limits<uint16_t>::max()},
+    {"r32ui", std::numeric_limits<uint32_t>::max()}};
+
 CameraSensor::CameraSensor(
-    UCameraComponent* camera_component, const std::vector<std::string>& render_pass_names, unsigned int width, unsigned int height, float fov)
+    UCameraComponent* camera_component, const std::vector<std::string>& render_pass_names, unsigned int width, unsigned int height, float fov,
+    const std::string& name, bool use_derived_outputs)
 {
     SP_ASSERT(camera_component);
+    SP_ASSERT(name != "");
+
+    name_ = name;
 
     actor_ = camera_component->GetWorld()->SpawnActor<AActor>();
     SP_ASSERT(actor_);
-    
-    for (auto& render_pass_name : render_pass_names) {
+
+    schedule_ = std::make_unique<SensorSchedule>(
+        Config::get<double>("SP_SERVICES.LEGACY.CAMERA_SENSOR.UPDATE_RATE"),
+        Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.UPDATE_ON_DEMAND"));
+    SP_ASSERT(schedule_);
+
+    for (auto& render_pass_str : render_pass_names) {
         RenderPassDesc render_pass_desc;
 
+        // parse "<render_pass_name>:<output_format>"
+        std::vector<std::string> render_pass_tokens = Std::tokenize(render_pass_str, ":");
+        SP_ASSERT(render_pass_tokens.size() == 1 || render_pass_tokens.size() == 2);
+        std::string render_pass_name = render_pass_tokens.at(0);
+        SP_ASSERT(Std::containsKey(RENDER_PASS_OUTPUT_FORMATS, render_pass_name));
+        if (render_pass_tokens.size() == 2) {
+            render_pass_desc.output_format_ = render_pass_tokens.at(1);
+            SP_ASSERT(Std::contains(RENDER_PASS_OUTPUT_FORMATS.at(render_pass_name), render_pass_desc.output_format_));
+        } else {
+            render_pass_desc.output_format_ = RENDER_PASS_OUTPUT_FORMATS.at(render_pass_name).at(0);
+        }
+
         render_pass_desc.width_ = width;
         render_pass_desc.height_ = height;
-        render_pass_desc.num_bytes_ = height * width * RENDER_PASS_NUM_CHANNELS.at(render_pass_name) * RENDER_PASS_NUM_BYTES_PER_CHANNEL.at(render_pass_name);
+        render_pass_desc.readback_num_bytes_ = static_cast<uint64_t>(height) * width * RENDER_PASS_NUM_CHANNELS.at(render_pass_name) * RENDER_PASS_NUM_BYTES_PER_CHANNEL.at(render_pass_name);
+        render_pass_desc.num_bytes_ = static_cast<uint64_t>(height) * width *
+            OUTPUT_FORMAT_NUM_CHANNELS.at(render_pass_desc.output_format_) * OUTPUT_FORMAT_NUM_BYTES_PER_CHANNEL.at(render_pass_desc.output_format_);
+
+        // if we're compacting, we read back into an intermediate buffer and compact into the final destination
+        if (render_pass_desc.output_format_ != RENDER_PASS_OUTPUT_FORMATS.at(render_pass_name).at(0)) {
+            render_pass_desc.readback_buffer_.resize(render_pass_desc.readback_num_bytes_);
+        }
 
         // create TextureRenderTarget2D
         auto texture_render_target_2d = NewObject<UTextureRenderTarget2D>(actor_, Unreal::toFName("texture_render_target_2d_" + render_pass_name));
@@ -106,6 +191,10 @@ CameraSensor::CameraSensor(
         render_pass_desc.scene_capture_component_2d_->CaptureSource = ESceneCaptureSource::SCS_FinalToneCurveHDR;
         render_pass_desc.scene_capture_component_2d_->SetVisibility(true);
 
+        // we trigger captures explicitly from our tick function below, so we can skip them when they aren't needed
+        render_pass_desc.scene_capture_component_2d_->bCaptureEveryFrame = false;
+        render_pass_desc.scene_capture_component_2d_->bCaptureOnMovement = false;
+
         if (render_pass_name == "final_color") {
             // need to override these settings to obtain the same rendering quality as in a default game viewport
             render_pass_desc.scene_capture_component_2d_->PostProcessSettings.bOverride_DynamicGlobalIlluminationMethod = true;
@@ -121,9 +210,23 @@ CameraSensor::CameraSensor(
             render_pass_desc.scene_capture_component_2d_->PostProcessSettings.AddBlendable(UMaterialInstanceDynamic::Create(material, actor_), 1.0f);
         }
 
+        // create CameraReadbackQueue
+        int readback_latency = Config::get<int>("SP_SERVICES.LEGACY.CAMERA_SENSOR.READBACK_LATENCY");
+        if (readback_latency > 0) {
+            render_pass_desc.readback_queue_ = std::make_unique<CameraReadbackQueue>(
+                readback_latency, width, height, RENDER_PASS_NUM_CHANNELS.at(render_pass_name) * RENDER_PASS_NUM_BYTES_PER_CHANNEL.at(render_pass_name));
+            SP_ASSERT(render_pass_desc.readback_queue_);
+        }
+
         // create shared_memory_object
         if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY")) {
-            render_pass_desc.shared_memory_name_ = "camera." + render_pass_name;
+            render_pass_desc.shared_memory_name_ = name_ + "." + render_pass_name;
+            render_pass_desc.use_triple_buffering_ = Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_TRIPLE_BUFFERING");
+
+            uint64_t shared_memory_num_bytes = render_pass_desc.num_bytes_;
+            if (render_pass_desc.use_triple_buffering_) {
+                shared_memory_num_bytes = SharedMemoryTripleBuffer::getNumBytes(render_pass_desc.num_bytes_);
+            }
 
             #if BOOST_OS_WINDOWS
                 render_pass_desc.shared_memory_id_ = render_pass_desc.shared_memory_name_; // don't use leading slash on Windows
@@ -131,7 +234,7 @@ CameraSensor::CameraSensor(
                     boost::interprocess::create_only,
                     render_pass_desc.shared_memory_id_.c_str(),
                     boost::interprocess::read_write,
-                    render_pass_desc.num_bytes_);
+                    shared_memory_num_bytes);
                 render_pass_desc.shared_memory_mapped_region_ = boost::interprocess::mapped_region(windows_shared_memory, boost::interprocess::read_write);
             #elif BOOST_OS_MACOS || BOOST_OS_LINUX
                 render_pass_desc.shared_memory_id_ = "/" + render_pass_desc.shared_memory_name_; // use leading slash on macOS and Linux
@@ -140,20 +243,133 @@ CameraSensor::CameraSensor(
                     boost::interprocess::create_only,
                     render_pass_desc.shared_memory_id_.c_str(),
                     boost::interprocess::read_write);
-                shared_memory_object.truncate(render_pass_desc.num_bytes_);
+                shared_memory_object.truncate(shared_memory_num_bytes);
                 render_pass_desc.shared_memory_mapped_region_ = boost::interprocess::mapped_region(shared_memory_object, boost::interprocess::read_write);
             #else
                 #error
             #endif
+
+            SharedMemoryRegion::applyFlags(render_pass_desc.shared_memory_mapped_region_, SharedMemoryRegion::getGlobalFlags());
+
+            if (render_pass_desc.use_triple_buffering_) {
+                SharedMemoryTripleBuffer::initialize(render_pass_desc.shared_memory_mapped_region_.get_address(), render_pass_desc.num_bytes_);
+            }
         }
 
         // update render_pass_descs_
         Std::insert(render_pass_descs_, render_pass_name, std::move(render_pass_desc));
     }
+
+    // Create derived outputs. DERIVED_OUTPUTS applies to all CameraSensors that use derived outputs, so we skip
+    // derived outputs for render passes that this CameraSensor doesn't have.
+    int downsampling_factor = Config::get<int>("SP_SERVICES.LEGACY.CAMERA_SENSOR.DOWNSAMPLING_FACTOR");
+    std::vector<std::string> derived_output_names;
+    if (use_derived_outputs) {
+        derived_output_names = Config::get<std::vector<std::string>>("SP_SERVICES.LEGACY.CAMERA_SENSOR.DERIVED_OUTPUTS");
+    }
+    for (auto& derived_output_name : derived_output_names) {
+
+        // parse "<render_pass_name>.<type>"
+        std::vector<std::string> derived_output_tokens = Std::tokenize(derived_output_name, ".");
+        SP_ASSERT(derived_output_tokens.size() == 2);
+        std::string render_pass_name = derived_output_tokens.at(0);
+        if (!Std::containsKey(render_pass_descs_, render_pass_name)) {
+            continue;
+        }
+
+        DerivedOutputDesc derived_output_desc;
+        derived_output_desc.render_pass_name_ = render_pass_name;
+        derived_output_desc.type_ = derived_output_tokens.at(1);
+
+        int num_bytes_per_channel = -1;
+        if (derived_output_desc.type_ == "point_cloud") {
+            SP_ASSERT(render_pass_name == "depth");
+            derived_output_desc.width_ = width;
+            derived_output_desc.height_ = height;
+            derived_output_desc.num_channels_ = 3;
+            derived_output_desc.datatype_ = DataType::Float32;
+            derived_output_desc.low_ = std::numeric_limits<double>::lowest();
+            derived_output_desc.high_ = std::numeric_limits<double>::max();
+            num_bytes_per_channel = 4;
+        } else if (derived_output_desc.type_ == "mm") {
+            SP_ASSERT(render_pass_name == "depth");
+            derived_output_desc.width_ = width;
+            derived_output_desc.height_ = height;
+            derived_output_desc.num_channels_ = 1;
+            derived_output_desc.datatype_ = DataType::UInteger16;
+            derived_output_desc.low_ = 0.0;
+            derived_output_desc.high_ = std::numeric_limits<uint16_t>::max();
+            num_bytes_per_channel = 2;
+        } else if (derived_output_desc.type_ == "downsampled") {
+            SP_ASSERT(downsampling_factor > 0);
+            SP_ASSERT(width % downsampling_factor == 0 && height % downsampling_factor == 0);
+            derived_output_desc.width_ = width / downsampling_factor;
+            derived_output_desc.height_ = height / downsampling_factor;
+            derived_output_desc.num_channels_ = RENDER_PASS_NUM_CHANNELS.at(render_pass_name);
+            derived_output_desc.datatype_ = RENDER_PASS_CHANNEL_DATATYPE.at(render_pass_name);
+            derived_output_desc.low_ = RENDER_PASS_LOW.at(render_pass_name);
+            derived_output_desc.high_ = RENDER_PASS_HIGH.at(render_pass_name);
+            num_bytes_per_channel = RENDER_PASS_NUM_BYTES_PER_CHANNEL.at(render_pass_name);
+        } else {
+            SP_ASSERT(false);
+        }
+        derived_output_desc.num_bytes_ = static_cast<uint64_t>(derived_output_desc.height_) * derived_output_desc.width_ *
+            derived_output_desc.num_channels_ * num_bytes_per_channel;
+
+        // create shared_memory_object
+        if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY")) {
+            derived_output_desc.shared_memory_name_ = name_ + "." + derived_output_name;
+
+            #if BOOST_OS_WINDOWS
+                derived_output_desc.shared_memory_id_ = derived_output_desc.shared_memory_name_; // don't use leading slash on Windows
+                boost::interprocess::windows_shared_memory windows_shared_memory(
+                    boost::interprocess::create_only,
+                    derived_output_desc.shared_memory_id_.c_str(),
+                    boost::interprocess::read_write,
+                    derived_output_desc.num_bytes_);
+                derived_output_desc.shared_memory_mapped_region_ = boost::interprocess::mapped_region(windows_shared_memory, boost::interprocess::read_write);
+            #elif BOOST_OS_MACOS || BOOST_OS_LINUX
+                derived_output_desc.shared_memory_id_ = "/" + derived_output_desc.shared_memory_name_; // use leading slash on macOS and Linux
+                boost::interprocess::shared_memory_object::remove(derived_output_desc.shared_memory_id_.c_str());
+                boost::interprocess::shared_memory_object shared_memory_object(
+                    boost::interprocess::create_only,
+                    derived_output_desc.shared_memory_id_.c_str(),
+                    boost::interprocess::read_write);
+                shared_memory_object.truncate(derived_output_desc.num_bytes_);
+                derived_output_desc.shared_memory_mapped_region_ = boost::interprocess::mapped_region(shared_memory_object, boost::interprocess::read_write);
+            #else
+                #error
+            #endif
+
+            SharedMemoryRegion::applyFlags(derived_output_desc.shared_memory_mapped_region_, SharedMemoryRegion::getGlobalFlags());
+        }
+
+        Std::insert(derived_output_descs_, derived_output_name, std::move(derived_output_desc));
+    }
+
+    // We tick after the camera has been moved for the current frame, but before the frame is rendered, so any captures
+    // we request are rendered along with the frame.
+    tick_component_ = std::make_unique<StandaloneComponent<UTickComponent>>(camera_component->GetWorld(), "tick_component");
+    SP_ASSERT(tick_component_);
+    SP_ASSERT(tick_component_->component_);
+    tick_component_->component_->PrimaryComponentTick.bCanEverTick = true;
+    tick_component_->component_->PrimaryComponentTick.bTickEvenWhenPaused = false;
+    tick_component_->component_->PrimaryComponentTick.TickGroup = ETickingGroup::TG_PostUpdateWork;
+    tick_component_->component_->setTickFunc([this](float delta_time, ELevelTick level_tick, FActorComponentTickFunction* this_tick_function) -> void {
+        if (isRenderingEnabled() && schedule_->shouldUpdate(actor_->GetWorld()->GetTimeSeconds())) {
+            for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
+                render_pass_desc.scene_capture_component_2d_->CaptureSceneDeferred();
+            }
+            capture_index_++;
+        }
+    });
 }
 
 CameraSensor::~CameraSensor()
 {
+    SP_ASSERT(tick_component_);
+    tick_component_ = nullptr;
+
     for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
         if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY")) {
             #if BOOST_OS_MACOS || BOOST_OS_LINUX
@@ -162,6 +378,14 @@ CameraSensor::~CameraSensor()
         }
     }
 
+    for (auto& [derived_output_name, derived_output_desc] : derived_output_descs_) {
+        if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY")) {
+            #if BOOST_OS_MACOS || BOOST_OS_LINUX
+                boost::interprocess::shared_memory_object::remove(derived_output_desc.shared_memory_id_.c_str());
+            #endif
+        }
+    }
+
     SP_ASSERT(actor_);
     actor_->Destroy();
     actor_ = nullptr;
@@ -174,14 +398,46 @@ std::map<std::string, ArrayDesc> CameraSensor::getObservationSpace() const
     for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
         ArrayDesc array_desc;
         array_desc.low_ = RENDER_PASS_LOW.at(render_pass_name);
-        array_desc.high_ = RENDER_PASS_HIGH.at(render_pass_name);
-        array_desc.shape_ = {render_pass_desc.height_, render_pass_desc.width_, RENDER_PASS_NUM_CHANNELS.at(render_pass_name)};
-        array_desc.datatype_ = RENDER_PASS_CHANNEL_DATATYPE.at(render_pass_name);
+        array_desc.high_ = Std::containsKey(OUTPUT_FORMAT_HIGH, render_pass_desc.output_format_) ?
+            OUTPUT_FORMAT_HIGH.at(render_pass_desc.output_format_) : RENDER_PASS_HIGH.at(render_pass_name);
+        array_desc.shape_ = {render_pass_desc.height_, render_pass_desc.width_, OUTPUT_FORMAT_NUM_CHANNELS.at(render_pass_desc.output_format_)};
+        array_desc.datatype_ = OUTPUT_FORMAT_CHANNEL_DATATYPE.at(render_pass_desc.output_format_);
         array_desc.use_shared_memory_ = Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY");
         array_desc.shared_memory_name_ = render_pass_desc.shared_memory_name_;
-        Std::insert(observation_space, "camera." + render_pass_name, std::move(array_desc));
+        array_desc.shared_memory_num_slots_ = render_pass_desc.use_triple_buffering_ ? SharedMemoryTripleBuffer::NUM_SLOTS : 1;
+        Std::insert(observation_space, name_ + "." + render_pass_name, std::move(array_desc));
+
+        // when reading back asynchronously, the image returned for a given step was rendered several frames
+        // earlier, so we tag each image with the index of the frame in which it was rendered
+        if (render_pass_desc.readback_queue_) {
+            ArrayDesc array_desc;
+            array_desc.low_ = -1.0;
+            array_desc.high_ = std::numeric_limits<int32_t>::max();
+            array_desc.shape_ = {1};
+            array_desc.datatype_ = DataType::Integer32;
+            Std::insert(observation_space, name_ + "." + render_pass_name + ".frame_index", std::move(array_desc));
+        }
     }
 
+    for (auto& [derived_output_name, derived_output_desc] : derived_output_descs_) {
+        ArrayDesc array_desc;
+        array_desc.low_ = derived_output_desc.low_;
+        array_desc.high_ = derived_output_desc.high_;
+        array_desc.shape_ = {derived_output_desc.height_, derived_output_desc.width_, derived_output_desc.num_channels_};
+        array_desc.datatype_ = derived_output_desc.datatype_;
+        array_desc.use_shared_memory_ = Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY");
+        array_desc.shared_memory_name_ = derived_output_desc.shared_memory_name_;
+        Std::insert(observation_space, name_ + "." + derived_output_name, std::move(array_desc));
+    }
+
+    // simulated time in seconds at which the render passes were most recently captured
+    ArrayDesc array_desc;
+    array_desc.low_ = -1.0;
+    array_desc.high_ = std::numeric_limits<double>::max();
+    array_desc.shape_ = {1};
+    array_desc.datatype_ = DataType::Float64;
+    Std::insert(observation_space, name_ + ".timestamp", std::move(array_desc));
+
     return observation_space;
 }
 
@@ -189,40 +445,165 @@ std::map<std::string, std::vector<uint8_t>> CameraSensor::getObservation() const
 {
     std::map<std::string, std::vector<uint8_t>> observation;
 
+    // If we're not capturing every frame, and nothing has been captured since the previous call, the image in shared
+    // memory is still current, so we can skip reading it back. We still need to read it back if we're returning it
+    // via msgpack.
+    bool captured = !schedule_->isThrottled() || capture_index_ != observed_capture_index_;
+    observed_capture_index_ = capture_index_;
+    bool read_surface_data =
+        Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.READ_SURFACE_DATA") && isRenderingEnabled() &&
+        (captured || !Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY"));
+
     for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
 
         void* dest_ptr = nullptr;
-        if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY")) {
+        if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY") && render_pass_desc.use_triple_buffering_) {
+            dest_ptr = SharedMemoryTripleBuffer::beginWrite(render_pass_desc.shared_memory_mapped_region_.get_address());
+        } else if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY")) {
             dest_ptr = render_pass_desc.shared_memory_mapped_region_.get_address();
         } else {
-            Std::insert(observation, "camera." + render_pass_name, {});
-            observation.at("camera." + render_pass_name).resize(render_pass_desc.num_bytes_);
-            dest_ptr = observation.at("camera." + render_pass_name).data();
+            Std::insert(observation, name_ + "." + render_pass_name, {});
+            observation.at(name_ + "." + render_pass_name).resize(render_pass_desc.num_bytes_);
+            dest_ptr = observation.at(name_ + "." + render_pass_name).data();
         }
         SP_ASSERT(dest_ptr);
 
-        if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.READ_SURFACE_DATA")) {
-            FTextureRenderTargetResource* texture_render_target_resource =
-                render_pass_desc.scene_capture_component_2d_->TextureTarget->GameThread_GetRenderTargetResource();
-            SP_ASSERT(texture_render_target_resource);
-
-            if (render_pass_name == "final_color" || render_pass_name == "segmentation") {
-                // ReadPixelsPtr assumes 4 channels per pixel, 1 byte per channel, so it can be used to read
-                // the following ETextureRenderTargetFormat formats:
-                //     final_color:  RTF_RGBA8
-                //     segmentation: RTF_RGBA8_SRGB
-                texture_render_target_resource->ReadPixelsPtr(static_cast<FColor*>(dest_ptr));
-            } else if (render_pass_name == "depth" || render_pass_name == "normal") {
-                // ReadLinearColorPixelsPtr assumes 4 channels per pixel, 4 bytes per channel, so it can be used
-                // to read the following ETextureRenderTargetFormat formats:
-                //     depth:  RTF_RGBA32f
-                //     normal: RTF_RGBA32f
-                texture_render_target_resource->ReadLinearColorPixelsPtr(static_cast<FLinearColor*>(dest_ptr));
+        bool compact = !render_pass_desc.readback_buffer_.empty();
+        void* readback_ptr = compact ? render_pass_desc.readback_buffer_.data() : dest_ptr;
+
+        bool publish = read_surface_data;
+
+        if (render_pass_desc.readback_queue_ && !read_surface_data) {
+            Std::insert(observation, name_ + "." + render_pass_name + ".frame_index", Std::reinterpretAsVector<uint8_t, int32_t>({-1}));
+
+        } else if (render_pass_desc.readback_queue_) {
+            render_pass_desc.readback_queue_->enqueueCopy(render_pass_desc.scene_capture_component_2d_->TextureTarget);
+            int32_t frame_index = static_cast<int32_t>(render_pass_desc.readback_queue_->read(readback_ptr));
+            publish = frame_index >= 0;
+            Std::insert(observation, name_ + "." + render_pass_name + ".frame_index", Std::reinterpretAsVector<uint8_t, int32_t>({frame_index}));
+
+        } else if (read_surface_data) {
+            readPixels(render_pass_name, render_pass_desc, readback_ptr);
+        }
+
+        if (compact && publish) {
+            RenderPassCompaction::compact(
+                render_pass_desc.output_format_, readback_ptr, dest_ptr, static_cast<uint64_t>(render_pass_desc.height_) * render_pass_desc.width_);
+        }
+
+        // derived outputs are computed from the 4-channel data, so we compute them before readback_ptr is reused
+        for (auto& [derived_output_name, derived_output_desc] : derived_output_descs_) {
+            if (derived_output_desc.render_pass_name_ != render_pass_name) {
+                continue;
+            }
+
+            void* derived_output_dest_ptr = nullptr;
+            if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY")) {
+                derived_output_dest_ptr = derived_output_desc.shared_memory_mapped_region_.get_address();
             } else {
-                SP_ASSERT(false);
+                Std::insert(observation, name_ + "." + derived_output_name, {});
+                observation.at(name_ + "." + derived_output_name).resize(derived_output_desc.num_bytes_);
+                derived_output_dest_ptr = observation.at(name_ + "." + derived_output_name).data();
             }
+            SP_ASSERT(derived_output_dest_ptr);
+
+            if (publish) {
+                computeDerivedOutput(derived_output_desc, readback_ptr, derived_output_dest_ptr);
+            }
+        }
+
+        if (Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY") && render_pass_desc.use_triple_buffering_ && publish) {
+            SharedMemoryTripleBuffer::endWrite(render_pass_desc.shared_memory_mapped_region_.get_address());
         }
     }
 
+    Std::insert(observation, name_ + ".timestamp", Std::reinterpretAsVector<uint8_t, double>({schedule_->update_time_}));
+
     return observation;
 }
+
+void CameraSensor::readRenderPass(const std::string& render_pass_name, void* dest_ptr) const
+{
+    SP_ASSERT(dest_ptr);
+
+    const RenderPassDesc& render_pass_desc = render_pass_descs_.at(render_pass_name);
+    bool compact = !render_pass_desc.readback_buffer_.empty();
+    void* readback_ptr = compact ? render_pass_desc.readback_buffer_.data() : dest_ptr;
+
+    readPixels(render_pass_name, render_pass_desc, readback_ptr);
+
+    if (compact) {
+        RenderPassCompaction::compact(
+            render_pass_desc.output_format_, readback_ptr, dest_ptr, static_cast<uint64_t>(render_pass_desc.height_) * render_pass_desc.width_);
+    }
+}
+
+void CameraSensor::setTickEnabled(bool enabled)
+{
+    SP_ASSERT(tick_component_);
+    SP_ASSERT(tick_component_->component_);
+    tick_component_->component_->SetComponentTickEnabled(enabled);
+}
+
+void CameraSensor::requestUpdate()
+{
+    schedule_->requestUpdate();
+}
+
+void CameraSensor::setRenderingEnabled(bool enabled)
+{
+    s_rendering_enabled_ = enabled;
+}
+
+bool CameraSensor::isRenderingEnabled()
+{
+    return s_rendering_enabled_;
+}
+
+void CameraSensor::computeDerivedOutput(const DerivedOutputDesc& derived_output_desc, const void* readback_ptr, void* dest_ptr) const
+{
+    const RenderPassDesc& render_pass_desc = render_pass_descs_.at(derived_output_desc.render_pass_name_);
+    int width = render_pass_desc.width_;
+    int height = render_pass_desc.height_;
+    int downsampling_factor = width / derived_output_desc.width_;
+
+    if (derived_output_desc.type_ == "point_cloud") {
+        DerivedOutputs::computePointCloud(
+            static_cast<const float*>(readback_ptr), static_cast<float*>(dest_ptr), width, height, render_pass_desc.scene_capture_component_2d_->FOVAngle);
+    } else if (derived_output_desc.type_ == "mm") {
+        DerivedOutputs::quantizeDepthToMillimeters(static_cast<const float*>(readback_ptr), static_cast<uint16_t*>(dest_ptr), width, height);
+    } else if (derived_output_desc.type_ == "downsampled" && derived_output_desc.render_pass_name_ == "segmentation") {
+        DerivedOutputs::subsampleBGRA8(static_cast<const uint8_t*>(readback_ptr), static_cast<uint8_t*>(dest_ptr), width, height, downsampling_factor);
+    } else if (derived_output_desc.type_ == "downsampled" && derived_output_desc.datatype_ == DataType::UInteger8) {
+        DerivedOutputs::downsampleBGRA8(static_cast<const uint8_t*>(readback_ptr), static_cast<uint8_t*>(dest_ptr), width, height, downsampling_factor);
+    } else if (derived_output_desc.type_ == "downsampled" && derived_output_desc.datatype_ == DataType::Float32) {
+        DerivedOutputs::downsampleRGBA32F(static_cast<const float*>(readback_ptr), static_cast<float*>(dest_ptr), width, height, downsampling_factor);
+    } else {
+        SP_ASSERT(false);
+    }
+}
+
+void CameraSensor::readPixels(const std::string& render_pass_name, const RenderPassDesc& render_pass_desc, void* readback_ptr)
+{
+    SP_ASSERT(readback_ptr);
+
+    FTextureRenderTargetResource* texture_render_target_resource =
+        render_pass_desc.scene_capture_component_2d_->TextureTarget->GameThread_GetRenderTargetResource();
+    SP_ASSERT(texture_render_target_resource);
+
+    if (render_pass_name == "final_color" || render_pass_name == "segmentation") {
+        // ReadPixelsPtr assumes 4 channels per pixel, 1 byte per channel, so it can be used to read
+        // the following ETextureRenderTargetFormat formats:
+        //     final_color:  RTF_RGBA8
+        //     segmentation: RTF_RGBA8_SRGB
+        texture_render_target_resource->ReadPixelsPtr(static_cast<FColor*>(readback_ptr));
+    } else if (render_pass_name == "depth" || render_pass_name == "normal") {
+        // ReadLinearColorPixelsPtr assumes 4 channels per pixel, 4 bytes per channel, so it can be used
+        // to read the following ETextureRenderTargetFormat formats:
+        //     depth:  RTF_RGBA32f
+        //     normal: RTF_RGBA32f
+        texture_render_target_resource->ReadLinearColorPixelsPtr(static_cast<FLinearColor*>(readback_ptr));
+    } else {
+        SP_ASSERT(false);
+    }
+}
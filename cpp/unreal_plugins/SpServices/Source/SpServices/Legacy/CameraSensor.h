@@ -4,15 +4,21 @@
 
 #pragma once
 
-#include <stdint.h> // uint8_t
+#include <stdint.h> // uint8_t, uint64_t
 
 #include <map>
+#include <memory> // std::unique_ptr
 #include <string>
 #include <vector>
 
 #include "SpCore/ArrayDesc.h" // TODO: remove
 #include "SpCore/Boost.h"
 
+#include "SpServices/Legacy/CameraReadbackQueue.h"
+#include "SpServices/Legacy/SensorSchedule.h"
+#include "SpServices/Legacy/StandaloneComponent.h"
+#include "SpServices/Legacy/TickComponent.h"
+
 class AActor;
 class UCameraComponent;
 class USceneCaptureComponent2D;
@@ -24,28 +30,97 @@ struct RenderPassDesc
     // strictly speaking, we could store width and height once for all render passes, but we store them here for simplicity
     int width_ = -1;
     int height_ = -1;
-    int num_bytes_ = -1;
+    uint64_t num_bytes_ = 0;          // size of the observation after it has been converted to output_format_
+    uint64_t readback_num_bytes_ = 0; // size of the 4-channel data returned by Unreal's ReadPixels functions
+
+    // if output_format_ is not the default format for this render pass, the 4-channel data is read back into
+    // readback_buffer_ and then compacted into the observation
+    std::string output_format_;
+    mutable std::vector<uint8_t> readback_buffer_;
 
     // only used if SIMULATION_CONTROLLER.CAMERA_SENSOR.USE_SHARED_MEMORY is set to True
     std::string shared_memory_name_; // externally visible name
     std::string shared_memory_id_;   // ID used to manage the shared memory resource internally
     boost::interprocess::mapped_region shared_memory_mapped_region_;
+
+    // only used if SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_TRIPLE_BUFFERING is set to True
+    bool use_triple_buffering_ = false;
+
+    // only used if SP_SERVICES.LEGACY.CAMERA_SENSOR.READBACK_LATENCY is greater than 0
+    std::unique_ptr<CameraReadbackQueue> readback_queue_;
+};
+
+struct DerivedOutputDesc
+{
+    std::string render_pass_name_; // render pass that this output is derived from
+    std::string type_;             // "point_cloud", "mm", or "downsampled"
+
+    int width_ = -1;
+    int height_ = -1;
+    int num_channels_ = -1;
+    DataType datatype_ = DataType::Invalid;
+    double low_ = 0.0;
+    double high_ = 0.0;
+    uint64_t num_bytes_ = 0;
+
+    // only used if SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY is set to True
+    std::string shared_memory_name_; // externally visible name
+    std::string shared_memory_id_;   // ID used to manage the shared memory resource internally
+    boost::interprocess::mapped_region shared_memory_mapped_region_;
 };
 
 class CameraSensor
 {
 public:
     CameraSensor() = delete;
-    CameraSensor(UCameraComponent* camera_component, const std::vector<std::string>& render_pass_names, unsigned int width, unsigned int height, float fov);
+    CameraSensor(
+        UCameraComponent* camera_component, const std::vector<std::string>& render_pass_names, unsigned int width, unsigned int height, float fov,
+        const std::string& name = "camera", // prefix for observation names and shared memory names
+        bool use_derived_outputs = true);   // if false, SP_SERVICES.LEGACY.CAMERA_SENSOR.DERIVED_OUTPUTS is ignored
     ~CameraSensor();
 
     // Used by Agents.
     std::map<std::string, ArrayDesc> getObservationSpace() const;
     std::map<std::string, std::vector<uint8_t>> getObservation() const;
 
+    const std::string& getName() const { return name_; }
+
+    // Synchronously reads the most recent capture of a render pass into dest_ptr, converted to its output format. Used
+    // by classes that trigger captures themselves, e.g., TrajectoryRenderer.
+    void readRenderPass(const std::string& render_pass_name, void* dest_ptr) const;
+
+    // If the tick function is disabled, render passes are only captured when user code calls CaptureScene() on them.
+    void setTickEnabled(bool enabled);
+
+    // Captures all render passes on the next frame if SP_SERVICES.LEGACY.CAMERA_SENSOR.UPDATE_ON_DEMAND is set to True.
+    void requestUpdate();
+
+    // If rendering is disabled, CameraSensors don't capture or read back any render passes, so observations in shared
+    // memory keep their previous contents. If the engine can't render at all (e.g., when running with -nullrhi),
+    // rendering stays enabled, and CameraReadbackQueue returns zero-filled images.
+    static void setRenderingEnabled(bool enabled);
+    static bool isRenderingEnabled();
+
     // Unreal resources for each render pass are public in case they need to be modified by user code.
     std::map<std::string, RenderPassDesc> render_pass_descs_;
 
+    // Outputs computed on the CPU from the render passes above, see SP_SERVICES.LEGACY.CAMERA_SENSOR.DERIVED_OUTPUTS.
+    std::map<std::string, DerivedOutputDesc> derived_output_descs_;
+
 private:
+    static void readPixels(const std::string& render_pass_name, const RenderPassDesc& render_pass_desc, void* readback_ptr);
+    void computeDerivedOutput(const DerivedOutputDesc& derived_output_desc, const void* readback_ptr, void* dest_ptr) const;
+
+    std::string name_;
     AActor* actor_ = nullptr;
+
+    std::unique_ptr<SensorSchedule> schedule_;
+    std::unique_ptr<StandaloneComponent<UTickComponent>> tick_component_;
+
+    // incremented every time the render passes are captured, so getObservation() can skip reading back render passes
+    // that haven't changed since the previous call
+    uint64_t capture_index_ = 0;
+    mutable uint64_t observed_capture_index_ = 0;
+
+    inline static bool s_rendering_enabled_ = true;
 };
@@ -22,9 +22,9 @@ class ClassRegistrationUtils;
 // defines the following static member variable.
 // 
 //     inline static auto s_class_registrar_ =
-//         ClassRegistrationUtils::getClassRegistrar<Agent, UWorld*>();
+//         ClassRegistrationUtils::getClassRegistrar<Agent, UWorld*, int>();
 //
-// The template parameters used here are the base class (Agent), and the types of any arguments (UWorld*) that should be
+// The template parameters used here are the base class (Agent), and the types of any arguments (UWorld*, int) that should be
 // passed into the constructor of the derived type. All derived types that we want to instantiate via this ClassRegistrar
 // object must provide a public constructor that accepts these types. To register a derived type with this ClassRegistrar
 // object, the derived type must define a static ClassRegistrationHandle member variable as follows.
@@ -38,10 +38,10 @@ class ClassRegistrationUtils;
 // Once these static member variables have been defined, we can instantiate a SphereAgent object at runtime as follows.
 //
 //     Agent* agent =
-//         ClassRegistrationUtils::create(Agent::s_class_registrar_, "SphereAgent", world);
+//         ClassRegistrationUtils::create(Agent::s_class_registrar_, "SphereAgent", world, agent_index);
 //
-// The world argument here is a UWorld* pointer. This function will return a new SphereAgent object that was constructed
-// using the SphereAgent::SphereAgent(UWorld* world) constructor.
+// The world argument here is a UWorld* pointer, and agent_index is an int. This function will return a new SphereAgent object
+// that was constructed using the SphereAgent::SphereAgent(UWorld* world, int agent_index) constructor.
 
 template <typename TBase, typename... TArgs>
 class ClassRegistrar
@@ -106,11 +106,11 @@ public:
         // slightly more readable and consistent, and to insulate user code from this implementation detail. In other words, we
         // think that this...
         // 
-        //     inline static auto s_class_registrar = ClassRegistrationUtils::getClassRegistrar<Agent, UWorld*>();
+        //     inline static auto s_class_registrar = ClassRegistrationUtils::getClassRegistrar<Agent, UWorld*, int>();
         // 
         // ...is slightly cleaner than this...
         //
-        //     inline static std::shared_ptr<ClassRegistrar<Agent, UWorld*>> s_class_registrar = nullptr;
+        //     inline static std::shared_ptr<ClassRegistrar<Agent, UWorld*, int>> s_class_registrar = nullptr;
         // 
         // ...even though both are functionally equivalent.
 
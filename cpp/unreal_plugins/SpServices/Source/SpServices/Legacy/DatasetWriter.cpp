@@ -0,0 +1,289 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/DatasetWriter.h"
+
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <algorithm>  // std::max
+#include <chrono>     // std::chrono::duration, std::chrono::steady_clock
+#include <filesystem> // std::filesystem::create_directories, std::filesystem::path
+#include <fstream>    // std::ofstream
+#include <map>
+#include <mutex>      // std::lock_guard, std::unique_lock
+#include <string>
+#include <utility>    // std::move
+#include <vector>
+
+#include <Containers/Array.h>     // TArray64
+#include <IImageWrapper.h>        // ERGBFormat, EImageFormat
+#include <IImageWrapperModule.h>
+#include <Modules/ModuleManager.h> // FModuleManager
+#include <Templates/SharedPointer.h>
+
+#include "SpCore/ArrayDesc.h" // TODO: remove
+#include "SpCore/Assert.h"
+#include "SpCore/Boost.h"
+#include "SpCore/Config.h"
+#include "SpCore/Std.h"
+
+#include "SpServices/Legacy/CameraSensor.h"
+
+DatasetWriter::DatasetWriter(const CameraSensor* camera_sensor, const std::string& directory, const std::map<std::string, std::string>& encodings)
+{
+    SP_ASSERT(camera_sensor);
+    camera_sensor_ = camera_sensor;
+    directory_ = directory;
+
+    // the ImageWrapper module must be loaded on the game thread, but image wrappers can be created on any thread
+    image_wrapper_module_ = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+    SP_ASSERT(image_wrapper_module_);
+
+    int max_num_pending_images = Config::get<int>("SP_SERVICES.LEGACY.DATASET_WRITER.MAX_NUM_PENDING_IMAGES");
+    int chunk_num_bytes = Config::get<int>("SP_SERVICES.LEGACY.DATASET_WRITER.CHUNK_NUM_BYTES");
+    SP_ASSERT(max_num_pending_images > 0);
+    SP_ASSERT(chunk_num_bytes > 0);
+    max_num_pending_images_ = max_num_pending_images;
+    chunk_num_bytes_ = chunk_num_bytes;
+
+    for (auto& render_pass_name : Std::keys(encodings)) {
+        SP_ASSERT(Std::containsKey(camera_sensor_->render_pass_descs_, render_pass_name));
+    }
+
+    std::map<std::string, ArrayDesc> observation_space = camera_sensor_->getObservationSpace();
+    for (auto& [render_pass_name, camera_render_pass_desc] : camera_sensor_->render_pass_descs_) {
+        const ArrayDesc& array_desc = observation_space.at(camera_sensor_->getName() + "." + render_pass_name);
+        SP_ASSERT(array_desc.shape_.size() == 3);
+
+        DatasetWriterRenderPassDesc render_pass_desc;
+        render_pass_desc.encoding_ = Std::containsKey(encodings, render_pass_name) ? encodings.at(render_pass_name) : "raw";
+        render_pass_desc.width_ = camera_render_pass_desc.width_;
+        render_pass_desc.height_ = camera_render_pass_desc.height_;
+        render_pass_desc.num_channels_ = static_cast<int>(array_desc.shape_.at(2));
+        render_pass_desc.datatype_ = array_desc.datatype_;
+        render_pass_desc.num_bytes_ = camera_render_pass_desc.num_bytes_;
+
+        // ImageWrapper only supports a subset of our output formats, so we check the requested encoding up front
+        // instead of failing on a worker thread
+        if (render_pass_desc.encoding_ == "png") {
+            if (render_pass_desc.num_channels_ == 4 && render_pass_desc.datatype_ == DataType::UInteger8) {
+                render_pass_desc.rgb_format_ = ERGBFormat::BGRA;
+                render_pass_desc.bit_depth_ = 8;
+            } else if (render_pass_desc.num_channels_ == 1 && render_pass_desc.datatype_ == DataType::UInteger16) {
+                render_pass_desc.rgb_format_ = ERGBFormat::Gray;
+                render_pass_desc.bit_depth_ = 16;
+            } else {
+                SP_ASSERT(false);
+            }
+        } else if (render_pass_desc.encoding_ == "exr") {
+            if (render_pass_desc.num_channels_ == 4 && render_pass_desc.datatype_ == DataType::Float32) {
+                render_pass_desc.rgb_format_ = ERGBFormat::RGBAF;
+                render_pass_desc.bit_depth_ = 32;
+            } else if (render_pass_desc.num_channels_ == 1 && render_pass_desc.datatype_ == DataType::Float32) {
+                render_pass_desc.rgb_format_ = ERGBFormat::GrayF;
+                render_pass_desc.bit_depth_ = 32;
+            } else if (render_pass_desc.num_channels_ == 1 && render_pass_desc.datatype_ == DataType::Float16) {
+                render_pass_desc.rgb_format_ = ERGBFormat::GrayF;
+                render_pass_desc.bit_depth_ = 16;
+            } else {
+                SP_ASSERT(false);
+            }
+        } else {
+            SP_ASSERT(render_pass_desc.encoding_ == "raw");
+        }
+
+        std::filesystem::create_directories(std::filesystem::path(directory_) / render_pass_name);
+        Std::insert(render_pass_descs_, render_pass_name, std::move(render_pass_desc));
+    }
+
+    index_file_.open(std::filesystem::path(directory_) / "index.csv");
+    SP_ASSERT(index_file_.is_open());
+    index_file_ << "frame_index,render_pass_name,encoding,chunk_file,offset,num_bytes,height,width,num_channels,datatype" << std::endl;
+
+    int num_worker_threads = Config::get<int>("SP_SERVICES.LEGACY.DATASET_WRITER.NUM_WORKER_THREADS");
+    SP_ASSERT(num_worker_threads > 0);
+    for (int i = 0; i < num_worker_threads; i++) {
+        worker_threads_.emplace_back(&DatasetWriter::workerFunc, this);
+    }
+}
+
+DatasetWriter::~DatasetWriter()
+{
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    job_available_condition_variable_.notify_all();
+
+    for (auto& worker_thread : worker_threads_) {
+        worker_thread.join();
+    }
+    worker_threads_.clear();
+
+    for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
+        render_pass_desc.chunk_file_.close();
+    }
+    index_file_.close();
+}
+
+uint64_t DatasetWriter::submit()
+{
+    std::map<std::string, std::vector<uint8_t>> render_pass_data;
+    for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
+        std::vector<uint8_t> data(render_pass_desc.num_bytes_);
+        camera_sensor_->readRenderPass(render_pass_name, data.data());
+        Std::insert(render_pass_data, render_pass_name, std::move(data));
+    }
+
+    return submit(std::move(render_pass_data));
+}
+
+uint64_t DatasetWriter::submit(std::map<std::string, std::vector<uint8_t>>&& render_pass_data)
+{
+    uint64_t frame_index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frame_index = num_frames_submitted_++;
+    }
+
+    for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
+        DatasetWriterJob job;
+        job.frame_index_ = frame_index;
+        job.render_pass_name_ = render_pass_name;
+        job.data_ = std::move(render_pass_data.at(render_pass_name));
+        SP_ASSERT(job.data_.size() == render_pass_desc.num_bytes_);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (jobs_.size() >= max_num_pending_images_) {
+                auto wait_begin_time = std::chrono::steady_clock::now();
+                job_done_condition_variable_.wait(lock, [this]() -> bool { return jobs_.size() < max_num_pending_images_; });
+                blocked_time_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_begin_time).count();
+                num_times_blocked_++;
+            }
+            jobs_.push_back(std::move(job));
+            max_num_images_pending_observed_ = std::max(max_num_images_pending_observed_, static_cast<uint64_t>(jobs_.size()));
+        }
+        job_available_condition_variable_.notify_one();
+    }
+
+    return frame_index;
+}
+
+void DatasetWriter::flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        job_done_condition_variable_.wait(lock, [this]() -> bool { return jobs_.empty() && num_images_in_progress_ == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    for (auto& [render_pass_name, render_pass_desc] : render_pass_descs_) {
+        if (render_pass_desc.chunk_file_.is_open()) {
+            render_pass_desc.chunk_file_.flush();
+        }
+    }
+    index_file_.flush();
+}
+
+std::map<std::string, double> DatasetWriter::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        {"num_frames_submitted",            static_cast<double>(num_frames_submitted_)},
+        {"num_images_pending",              static_cast<double>(jobs_.size() + num_images_in_progress_)},
+        {"max_num_images_pending_observed", static_cast<double>(max_num_images_pending_observed_)},
+        {"num_images_written",              static_cast<double>(num_images_written_)},
+        {"num_bytes_written",               static_cast<double>(num_bytes_written_)},
+        {"num_times_blocked",               static_cast<double>(num_times_blocked_)},
+        {"blocked_time",                    blocked_time_},
+        {"encode_time",                     encode_time_}};
+}
+
+void DatasetWriter::workerFunc()
+{
+    while (true) {
+        DatasetWriterJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job_available_condition_variable_.wait(lock, [this]() -> bool { return stop_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+            num_images_in_progress_++;
+        }
+
+        // a slot in the queue is now free, so wake up submit() if it is waiting
+        job_done_condition_variable_.notify_all();
+
+        DatasetWriterRenderPassDesc& render_pass_desc = render_pass_descs_.at(job.render_pass_name_);
+
+        auto encode_begin_time = std::chrono::steady_clock::now();
+        std::vector<uint8_t> encoded_data = encode(render_pass_desc, job.data_);
+        double encode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - encode_begin_time).count();
+        job.data_.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(file_mutex_);
+
+            if (!render_pass_desc.chunk_file_.is_open() || render_pass_desc.chunk_num_bytes_ >= chunk_num_bytes_) {
+                render_pass_desc.chunk_file_.close();
+                render_pass_desc.chunk_index_++;
+                render_pass_desc.chunk_num_bytes_ = 0;
+                render_pass_desc.chunk_file_.open(
+                    std::filesystem::path(directory_) / job.render_pass_name_ / ("chunk_" + (boost::format("%06d")%render_pass_desc.chunk_index_).str() + ".bin"),
+                    std::ios::binary);
+                SP_ASSERT(render_pass_desc.chunk_file_.is_open());
+            }
+
+            uint64_t offset = render_pass_desc.chunk_num_bytes_;
+            render_pass_desc.chunk_file_.write(reinterpret_cast<const char*>(encoded_data.data()), encoded_data.size());
+            SP_ASSERT(render_pass_desc.chunk_file_.good());
+            render_pass_desc.chunk_num_bytes_ += encoded_data.size();
+
+            index_file_ <<
+                job.frame_index_ << "," <<
+                job.render_pass_name_ << "," <<
+                render_pass_desc.encoding_ << "," <<
+                job.render_pass_name_ << "/chunk_" << (boost::format("%06d")%render_pass_desc.chunk_index_).str() << ".bin," <<
+                offset << "," <<
+                encoded_data.size() << "," <<
+                render_pass_desc.height_ << "," <<
+                render_pass_desc.width_ << "," <<
+                render_pass_desc.num_channels_ << "," <<
+                static_cast<int>(render_pass_desc.datatype_) << "\n";
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            num_images_in_progress_--;
+            num_images_written_++;
+            num_bytes_written_ += encoded_data.size();
+            encode_time_ += encode_time;
+        }
+        job_done_condition_variable_.notify_all();
+    }
+}
+
+std::vector<uint8_t> DatasetWriter::encode(const DatasetWriterRenderPassDesc& render_pass_desc, const std::vector<uint8_t>& data) const
+{
+    if (render_pass_desc.encoding_ == "raw") {
+        return data;
+    }
+
+    EImageFormat image_format = (render_pass_desc.encoding_ == "png") ? EImageFormat::PNG : EImageFormat::EXR;
+    TSharedPtr<IImageWrapper> image_wrapper = image_wrapper_module_->CreateImageWrapper(image_format);
+    SP_ASSERT(image_wrapper.IsValid());
+
+    bool success = image_wrapper->SetRaw(
+        data.data(), data.size(), render_pass_desc.width_, render_pass_desc.height_, render_pass_desc.rgb_format_, render_pass_desc.bit_depth_);
+    SP_ASSERT(success);
+
+    TArray64<uint8> compressed_data = image_wrapper->GetCompressed();
+    return std::vector<uint8_t>(compressed_data.GetData(), compressed_data.GetData() + compressed_data.Num());
+}
@@ -0,0 +1,113 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <condition_variable>
+#include <deque>
+#include <fstream> // std::ofstream
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <IImageWrapper.h> // ERGBFormat
+
+#include "SpCore/ArrayDesc.h" // TODO: remove
+
+class CameraSensor;
+class IImageWrapperModule;
+
+struct DatasetWriterRenderPassDesc
+{
+    std::string encoding_; // "raw", "png", or "exr"
+
+    int width_ = -1;
+    int height_ = -1;
+    int num_channels_ = -1;
+    DataType datatype_ = DataType::Invalid;
+    uint64_t num_bytes_ = 0;
+
+    // only used if encoding_ is "png" or "exr"
+    ERGBFormat rgb_format_ = ERGBFormat::Invalid;
+    int bit_depth_ = -1;
+
+    // encoded images are appended to the current chunk file until it reaches CHUNK_NUM_BYTES
+    int chunk_index_ = -1;
+    uint64_t chunk_num_bytes_ = 0;
+    std::ofstream chunk_file_;
+};
+
+struct DatasetWriterJob
+{
+    uint64_t frame_index_ = 0;
+    std::string render_pass_name_;
+    std::vector<uint8_t> data_;
+};
+
+// A DatasetWriter reads every render pass of a CameraSensor on the game thread, and then encodes and writes the
+// images on a pool of worker threads, so the game thread never waits for encoding or disk I/O unless the workers
+// fall behind. Encoded images are appended to chunk files named <directory>/<render_pass_name>/chunk_<index>.bin,
+// and each image is listed in <directory>/index.csv along with its chunk file, byte offset, and size. The encoding
+// of each render pass is "raw" by default, "png" is supported for 8-bit BGRA and 16-bit grayscale output formats,
+// and "exr" is supported for 32-bit RGBA and 16-bit or 32-bit grayscale floating-point output formats.
+//
+// If more than SP_SERVICES.LEGACY.DATASET_WRITER.MAX_NUM_PENDING_IMAGES images are waiting to be encoded, submit()
+// blocks until a worker thread catches up. getStats() reports how often and for how long this happened.
+class DatasetWriter
+{
+public:
+    DatasetWriter() = delete;
+    DatasetWriter(const CameraSensor* camera_sensor, const std::string& directory, const std::map<std::string, std::string>& encodings);
+    ~DatasetWriter();
+
+    // Reads back the most recent capture of every render pass, and queues it for encoding. Returns the index of the
+    // frame in index.csv.
+    uint64_t submit();
+
+    // Queues images that the caller has already read back, e.g., asynchronously. render_pass_data must contain an
+    // image for every render pass, in the same format as CameraSensor::readRenderPass(...).
+    uint64_t submit(std::map<std::string, std::vector<uint8_t>>&& render_pass_data);
+
+    // Blocks until every submitted image has been written to disk.
+    void flush();
+
+    std::map<std::string, double> getStats() const;
+
+private:
+    void workerFunc();
+    std::vector<uint8_t> encode(const DatasetWriterRenderPassDesc& render_pass_desc, const std::vector<uint8_t>& data) const;
+
+    const CameraSensor* camera_sensor_ = nullptr;
+    IImageWrapperModule* image_wrapper_module_ = nullptr;
+
+    std::string directory_;
+    std::map<std::string, DatasetWriterRenderPassDesc> render_pass_descs_;
+    uint64_t max_num_pending_images_ = 0;
+    uint64_t chunk_num_bytes_ = 0;
+
+    // guards the job queue and all stats
+    mutable std::mutex mutex_;
+    std::condition_variable job_available_condition_variable_;
+    std::condition_variable job_done_condition_variable_;
+    std::deque<DatasetWriterJob> jobs_;
+    std::vector<std::thread> worker_threads_;
+    bool stop_ = false;
+
+    uint64_t num_frames_submitted_ = 0;
+    uint64_t num_images_in_progress_ = 0;
+    uint64_t max_num_images_pending_observed_ = 0;
+    uint64_t num_images_written_ = 0;
+    uint64_t num_bytes_written_ = 0;
+    uint64_t num_times_blocked_ = 0;
+    double blocked_time_ = 0.0; // seconds that submit() spent waiting for the worker threads
+    double encode_time_ = 0.0;  // seconds that the worker threads spent encoding, summed over all threads
+
+    // guards chunk files and index.csv
+    std::mutex file_mutex_;
+    std::ofstream index_file_;
+};
@@ -0,0 +1,161 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/DerivedOutputs.h"
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, uint64_t
+
+#include <algorithm> // std::clamp
+#include <cmath>     // std::lround
+
+#include <Async/ParallelFor.h>
+#include <HAL/Platform.h>           // int32
+#include <Math/UnrealMathUtility.h> // FMath
+#include <Math/VectorRegister.h>    // MakeVectorRegisterFloat, VectorLoad, VectorMultiply, VectorShuffle, VectorStore, ...
+
+#include "SpCore/Assert.h"
+
+void DerivedOutputs::computePointCloud(const float* src, float* dest, int width, int height, float fov)
+{
+    SP_ASSERT(src);
+    SP_ASSERT(dest);
+    SP_ASSERT(fov > 0.0f && fov < 180.0f);
+
+    // Unreal's FOVAngle is the horizontal field of view, and pixels are square, so the same focal length applies
+    // to both axes. We sample at pixel centers.
+    float focal_length = 0.5f * width / FMath::Tan(FMath::DegreesToRadians(0.5f * fov));
+    float inv_focal_length = 1.0f / focal_length;
+    float center_x = 0.5f * width;
+    float center_y = 0.5f * height;
+
+    ParallelFor(height, [src, dest, width, inv_focal_length, center_x, center_y](int32 v) -> void {
+        const float* src_row = src + static_cast<uint64_t>(v)*width*4;
+        float* dest_row = dest + static_cast<uint64_t>(v)*width*3;
+        float z_scale = (center_y - (v + 0.5f)) * inv_focal_length;
+
+        VectorRegister4Float pixel_offsets = MakeVectorRegisterFloat(0.5f, 1.5f, 2.5f, 3.5f);
+        VectorRegister4Float inv_focal_lengths = VectorSetFloat1(inv_focal_length);
+        VectorRegister4Float z_scales = VectorSetFloat1(z_scale);
+
+        int u = 0;
+        for (; u + 4 <= width; u += 4) {
+            // gather the depth of 4 pixels into a single register, see RenderPassCompaction::compactRGBA32FToR32F(...)
+            VectorRegister4Float pixels_01 = VectorShuffle(VectorLoad(src_row + 4*u), VectorLoad(src_row + 4*u + 4), 0, 0, 0, 0);
+            VectorRegister4Float pixels_23 = VectorShuffle(VectorLoad(src_row + 4*u + 8), VectorLoad(src_row + 4*u + 12), 0, 0, 0, 0);
+            VectorRegister4Float depths = VectorShuffle(pixels_01, pixels_23, 0, 2, 0, 2);
+
+            VectorRegister4Float us = VectorSubtract(VectorAdd(VectorSetFloat1(static_cast<float>(u)), pixel_offsets), VectorSetFloat1(center_x));
+            VectorRegister4Float ys = VectorMultiply(VectorMultiply(us, inv_focal_lengths), depths);
+            VectorRegister4Float zs = VectorMultiply(z_scales, depths);
+
+            float x_values[4];
+            float y_values[4];
+            float z_values[4];
+            VectorStore(depths, x_values);
+            VectorStore(ys, y_values);
+            VectorStore(zs, z_values);
+            for (int i = 0; i < 4; i++) {
+                dest_row[3*(u + i)]     = x_values[i];
+                dest_row[3*(u + i) + 1] = y_values[i];
+                dest_row[3*(u + i) + 2] = z_values[i];
+            }
+        }
+        for (; u < width; u++) {
+            float depth = src_row[4*u];
+            dest_row[3*u]     = depth;
+            dest_row[3*u + 1] = ((u + 0.5f) - center_x) * inv_focal_length * depth;
+            dest_row[3*u + 2] = z_scale * depth;
+        }
+    });
+}
+
+void DerivedOutputs::quantizeDepthToMillimeters(const float* src, uint16_t* dest, int width, int height)
+{
+    SP_ASSERT(src);
+    SP_ASSERT(dest);
+
+    ParallelFor(height, [src, dest, width](int32 v) -> void {
+        const float* src_row = src + static_cast<uint64_t>(v)*width*4;
+        uint16_t* dest_row = dest + static_cast<uint64_t>(v)*width;
+        for (int u = 0; u < width; u++) {
+            float depth_mm = std::clamp(1000.0f*src_row[4*u], 0.0f, 65535.0f);
+            dest_row[u] = static_cast<uint16_t>(std::lround(depth_mm));
+        }
+    });
+}
+
+void DerivedOutputs::downsampleBGRA8(const uint8_t* src, uint8_t* dest, int width, int height, int factor)
+{
+    SP_ASSERT(src);
+    SP_ASSERT(dest);
+    SP_ASSERT(factor > 0);
+    SP_ASSERT(width % factor == 0 && height % factor == 0);
+
+    int dest_width = width / factor;
+    uint32_t num_pixels_per_block = factor*factor;
+
+    ParallelFor(height / factor, [src, dest, width, factor, dest_width, num_pixels_per_block](int32 dest_v) -> void {
+        for (int dest_u = 0; dest_u < dest_width; dest_u++) {
+            uint32_t sums[4] = {0, 0, 0, 0};
+            for (int dv = 0; dv < factor; dv++) {
+                const uint8_t* src_pixel = src + (static_cast<uint64_t>(dest_v*factor + dv)*width + dest_u*factor)*4;
+                for (int du = 0; du < factor; du++) {
+                    sums[0] += src_pixel[4*du];
+                    sums[1] += src_pixel[4*du + 1];
+                    sums[2] += src_pixel[4*du + 2];
+                    sums[3] += src_pixel[4*du + 3];
+                }
+            }
+            uint8_t* dest_pixel = dest + (static_cast<uint64_t>(dest_v)*dest_width + dest_u)*4;
+            for (int c = 0; c < 4; c++) {
+                dest_pixel[c] = static_cast<uint8_t>((sums[c] + num_pixels_per_block/2) / num_pixels_per_block); // round to nearest
+            }
+        }
+    });
+}
+
+void DerivedOutputs::downsampleRGBA32F(const float* src, float* dest, int width, int height, int factor)
+{
+    SP_ASSERT(src);
+    SP_ASSERT(dest);
+    SP_ASSERT(factor > 0);
+    SP_ASSERT(width % factor == 0 && height % factor == 0);
+
+    int dest_width = width / factor;
+    VectorRegister4Float inv_num_pixels_per_block = VectorSetFloat1(1.0f / (factor*factor));
+
+    // each pixel is exactly one register wide, so we can accumulate all 4 channels at once
+    ParallelFor(height / factor, [src, dest, width, factor, dest_width, inv_num_pixels_per_block](int32 dest_v) -> void {
+        for (int dest_u = 0; dest_u < dest_width; dest_u++) {
+            VectorRegister4Float sum = VectorZeroFloat();
+            for (int dv = 0; dv < factor; dv++) {
+                const float* src_pixel = src + (static_cast<uint64_t>(dest_v*factor + dv)*width + dest_u*factor)*4;
+                for (int du = 0; du < factor; du++) {
+                    sum = VectorAdd(sum, VectorLoad(src_pixel + 4*du));
+                }
+            }
+            VectorStore(VectorMultiply(sum, inv_num_pixels_per_block), dest + (static_cast<uint64_t>(dest_v)*dest_width + dest_u)*4);
+        }
+    });
+}
+
+void DerivedOutputs::subsampleBGRA8(const uint8_t* src, uint8_t* dest, int width, int height, int factor)
+{
+    SP_ASSERT(src);
+    SP_ASSERT(dest);
+    SP_ASSERT(factor > 0);
+    SP_ASSERT(width % factor == 0 && height % factor == 0);
+
+    int dest_width = width / factor;
+    const uint32_t* src_pixels = reinterpret_cast<const uint32_t*>(src);
+    uint32_t* dest_pixels = reinterpret_cast<uint32_t*>(dest);
+
+    ParallelFor(height / factor, [src_pixels, dest_pixels, width, factor, dest_width](int32 dest_v) -> void {
+        const uint32_t* src_row = src_pixels + static_cast<uint64_t>(dest_v*factor)*width;
+        uint32_t* dest_row = dest_pixels + static_cast<uint64_t>(dest_v)*dest_width;
+        for (int dest_u = 0; dest_u < dest_width; dest_u++) {
+            dest_row[dest_u] = src_row[dest_u*factor];
+        }
+    });
+}
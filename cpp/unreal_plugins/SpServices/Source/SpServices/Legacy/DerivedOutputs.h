@@ -0,0 +1,33 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint8_t, uint16_t, uint64_t
+
+// These functions compute outputs that clients would otherwise derive from a render pass in numpy, e.g., a point
+// cloud from a depth image. They run on the CPU right after a render pass has been read back, so less data needs
+// to be copied between processes. All functions take the 4-channel data returned by Unreal's ReadPixels functions
+// as input, and split the work across rows of the image with ParallelFor. The src and dest buffers must not
+// overlap.
+class DerivedOutputs
+{
+public:
+    DerivedOutputs() = delete;
+    ~DerivedOutputs() = delete;
+
+    // Computes a (x, y, z) point in meters for each pixel in the camera frame (x forward, y right, z up), from a depth
+    // image that stores planar depth in meters in its first channel. fov is the horizontal field of view in degrees.
+    static void computePointCloud(const float* src, float* dest, int width, int height, float fov);
+
+    // Converts planar depth in meters to uint16 millimeters, values that don't fit are clamped to [0, 65535].
+    static void quantizeDepthToMillimeters(const float* src, uint16_t* dest, int width, int height);
+
+    // Averages each factor x factor block of pixels, width and height must be divisible by factor.
+    static void downsampleBGRA8(const uint8_t* src, uint8_t* dest, int width, int height, int factor);
+    static void downsampleRGBA32F(const float* src, float* dest, int width, int height, int factor);
+
+    // Keeps the top-left pixel of each factor x factor block, used for segmentation ids, which can't be averaged.
+    static void subsampleBGRA8(const uint8_t* src, uint8_t* dest, int width, int height, int factor);
+};
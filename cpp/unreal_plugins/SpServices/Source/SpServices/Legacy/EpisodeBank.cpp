@@ -0,0 +1,56 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/EpisodeBank.h"
+
+#include <stdint.h> // uint8_t, uint64_t
+#include <string.h> // memcmp, strncmp
+
+#include <string>
+#include <utility> // std::make_pair, std::pair
+
+#include "SpCore/Assert.h"
+#include "SpCore/Boost.h"
+#include "SpCore/Log.h"
+
+EpisodeBank::EpisodeBank(const std::string& file)
+{
+    SP_LOG("Mapping episode bank: ", file);
+
+    file_mapping_ = boost::interprocess::file_mapping(file.c_str(), boost::interprocess::read_only);
+    mapped_region_ = boost::interprocess::mapped_region(file_mapping_, boost::interprocess::read_only);
+    SP_ASSERT(mapped_region_.get_size() >= sizeof(EpisodeBankHeader));
+
+    const uint8_t* data = static_cast<const uint8_t*>(mapped_region_.get_address());
+    header_ = reinterpret_cast<const EpisodeBankHeader*>(data);
+    SP_ASSERT(memcmp(header_->magic_, "SPEPBANK", sizeof(header_->magic_)) == 0);
+    SP_ASSERT(header_->version_ == VERSION);
+    SP_ASSERT(header_->episode_num_bytes_ == sizeof(EpisodeBankEpisode));
+    SP_ASSERT(header_->scene_table_offset_ + header_->num_scenes_*sizeof(EpisodeBankScene) <= mapped_region_.get_size());
+    SP_ASSERT(header_->episode_table_offset_ + header_->num_episodes_*sizeof(EpisodeBankEpisode) <= mapped_region_.get_size());
+
+    scenes_ = reinterpret_cast<const EpisodeBankScene*>(data + header_->scene_table_offset_);
+    episodes_ = reinterpret_cast<const EpisodeBankEpisode*>(data + header_->episode_table_offset_);
+}
+
+uint64_t EpisodeBank::getNumEpisodes() const
+{
+    return header_->num_episodes_;
+}
+
+const EpisodeBankEpisode& EpisodeBank::getEpisode(uint64_t episode_index) const
+{
+    SP_ASSERT(episode_index < header_->num_episodes_);
+    return episodes_[episode_index];
+}
+
+std::pair<uint64_t, uint64_t> EpisodeBank::getEpisodeRange(const std::string& scene_id) const
+{
+    for (uint64_t i = 0; i < header_->num_scenes_; i++) {
+        if (strncmp(scenes_[i].scene_id_, scene_id.c_str(), sizeof(scenes_[i].scene_id_)) == 0) {
+            return std::make_pair(scenes_[i].first_episode_index_, scenes_[i].num_episodes_);
+        }
+    }
+    return std::make_pair(0, 0);
+}
@@ -0,0 +1,75 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint32_t, uint64_t
+
+#include <string>
+#include <utility> // std::pair
+
+#include "SpCore/Boost.h"
+
+//
+// An episode bank is a binary file of episodes that is memory-mapped read-only, so every instance on a machine
+// shares the same physical pages, and opening a bank doesn't need to parse anything. The file begins with an
+// EpisodeBankHeader, followed by a table of num_scenes_ EpisodeBankScene entries, followed by num_episodes_
+// fixed-size EpisodeBankEpisode records. Records are sorted by scene, so the episodes for each scene are a
+// contiguous range of records, and any episode can be accessed in constant time by its index. All values are
+// little-endian. Episode banks are generated by tools/generate_episode_bank.py, and the layout must be kept in
+// sync with that file.
+//
+
+struct EpisodeBankHeader
+{
+    char magic_[8];                 // "SPEPBANK"
+    uint32_t version_;
+    uint32_t episode_num_bytes_;    // sizeof(EpisodeBankEpisode)
+    uint64_t num_scenes_;
+    uint64_t num_episodes_;
+    uint64_t scene_table_offset_;   // offset of the first EpisodeBankScene relative to the start of the file
+    uint64_t episode_table_offset_; // offset of the first EpisodeBankEpisode relative to the start of the file
+    uint64_t reserved_[2];
+};
+static_assert(sizeof(EpisodeBankHeader) == 64);
+
+struct EpisodeBankScene
+{
+    char scene_id_[64]; // null-terminated
+    uint64_t first_episode_index_;
+    uint64_t num_episodes_;
+};
+static_assert(sizeof(EpisodeBankScene) == 80);
+
+struct EpisodeBankEpisode
+{
+    double initial_location_[3];
+    double goal_location_[3];
+    uint32_t scene_index_;
+    uint32_t reserved_;
+};
+static_assert(sizeof(EpisodeBankEpisode) == 56);
+
+class EpisodeBank
+{
+public:
+    EpisodeBank() = delete;
+    EpisodeBank(const std::string& file);
+
+    uint64_t getNumEpisodes() const;
+    const EpisodeBankEpisode& getEpisode(uint64_t episode_index) const;
+
+    // returns (first_episode_index, num_episodes) for scene_id, or (0, 0) if the bank has no episodes for scene_id
+    std::pair<uint64_t, uint64_t> getEpisodeRange(const std::string& scene_id) const;
+
+    static constexpr uint32_t VERSION = 1;
+
+private:
+    boost::interprocess::file_mapping file_mapping_;
+    boost::interprocess::mapped_region mapped_region_;
+
+    const EpisodeBankHeader* header_ = nullptr;
+    const EpisodeBankScene* scenes_ = nullptr;
+    const EpisodeBankEpisode* episodes_ = nullptr;
+};
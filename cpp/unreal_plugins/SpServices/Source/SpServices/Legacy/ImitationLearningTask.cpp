@@ -4,14 +4,15 @@
 
 #include "SpServices/Legacy/ImitationLearningTask.h"
 
-#include <stdint.h> // uint8_t
+#include <stdint.h> // int64_t, uint8_t, uint64_t
 
 #include <fstream> // std::ifstream
 #include <limits>  // std::numeric_limits
 #include <map>
 #include <memory>  // std::make_unique
+#include <span>
 #include <string>  // std::getline, std::stod
-#include <utility> // std::move
+#include <utility> // std::move, std::pair
 #include <vector>
 
 #include <Components/SceneComponent.h>
@@ -27,14 +28,18 @@
 #include "SpCore/Unreal.h"
 
 #include "SpServices/Legacy/ActorHitComponent.h"
+#include "SpServices/Legacy/AgentInstance.h"
+#include "SpServices/Legacy/EpisodeBank.h"
 #include "SpServices/Legacy/StandaloneComponent.h"
 
 struct FHitResult;
 
-ImitationLearningTask::ImitationLearningTask(UWorld* world)
+ImitationLearningTask::ImitationLearningTask(UWorld* world, int agent_index)
 {
+    agent_index_ = agent_index;
+
     FActorSpawnParameters actor_spawn_parameters;
-    actor_spawn_parameters.Name = Unreal::toFName(Config::get<std::string>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.GOAL_ACTOR_NAME"));
+    actor_spawn_parameters.Name = Unreal::toFName(AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.GOAL_ACTOR_NAME"), agent_index_));
     actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
     goal_actor_ = world->SpawnActor<AActor>(FVector::ZeroVector, FRotator::ZeroRotator, actor_spawn_parameters);
     SP_ASSERT(goal_actor_);
@@ -54,10 +59,19 @@ ImitationLearningTask::ImitationLearningTask(UWorld* world)
     agent_initial_locations_.clear();
     agent_goal_locations_.clear();
     episode_index_ = -1;
+    num_episodes_ = 0;
+
+    // If an episode bank is set, we map it once here rather than parsing EPISODES_FILE every time the scene changes.
+    if (Config::get<std::string>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.EPISODE_BANK_FILE") != "") {
+        episode_bank_ = std::make_unique<EpisodeBank>(Config::get<std::string>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.EPISODE_BANK_FILE"));
+        SP_ASSERT(episode_bank_);
+    }
 }
 
 ImitationLearningTask::~ImitationLearningTask()
 {
+    episode_bank_ = nullptr;
+
     SP_ASSERT(actor_hit_component_);
     actor_hit_component_ = nullptr;
 
@@ -68,7 +82,7 @@ ImitationLearningTask::~ImitationLearningTask()
 
 void ImitationLearningTask::findObjectReferences(UWorld* world)
 {
-    agent_actor_ = Unreal::findActorByName(world, Config::get<std::string>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.AGENT_ACTOR_NAME"));
+    agent_actor_ = Unreal::findActorByName(world, AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.AGENT_ACTOR_NAME"), agent_index_));
     SP_ASSERT(agent_actor_);
 
     bool return_null_if_not_found = false;
@@ -164,7 +178,20 @@ void ImitationLearningTask::reset()
     std::string current_scene_id = Unreal::toStdString(world->GetName());
 
     // Only if we have changed the scene
-    if (previous_scene_id_ != current_scene_id) {
+    if (previous_scene_id_ != current_scene_id && episode_bank_) {
+        std::pair<uint64_t, uint64_t> episode_range = episode_bank_->getEpisodeRange(current_scene_id);
+        episode_bank_first_episode_index_ = episode_range.first;
+        num_episodes_ = episode_range.second;
+        SP_ASSERT(num_episodes_ > 0);
+
+        // reset the episode_index_ when we change to a new scene, vectorized agents start at different episodes so
+        // they don't all replay the same episode
+        episode_index_ = agent_index_ % num_episodes_;
+
+        // store the scene_id for future reference
+        previous_scene_id_ = current_scene_id;
+
+    } else if (previous_scene_id_ != current_scene_id) {
         // Since we are now moving across different scenes using the new open_level functionality, we do not need to spawn a new executable
         // everytime we want to open a new scene. Thus, the below functionality of reading from an episodes file needs to be moved 
         // away from the constructor to reset(). This is fine for now as we will move all of this functionality to python soon.
@@ -197,29 +224,52 @@ void ImitationLearningTask::reset()
             }
         }
         fs.close();
+        num_episodes_ = agent_initial_locations_.size();
+        SP_ASSERT(num_episodes_ > 0);
 
-        // reset the episode_index_ when we change to a new scene
-        episode_index_ = 0;
+        // reset the episode_index_ when we change to a new scene, vectorized agents start at different episodes so
+        // they don't all replay the same episode
+        episode_index_ = agent_index_ % num_episodes_;
 
         // store the scene_id for future reference
         previous_scene_id_ = current_scene_id;
     }
 
+    // the restored episode index takes precedence, even if we have changed the scene, because the episode index is
+    // reset when the scene changes
+    if (restored_episode_index_ >= 0) {
+        SP_ASSERT(restored_episode_index_ < num_episodes_);
+        episode_index_ = restored_episode_index_;
+        restored_episode_index_ = -1;
+    }
+
     FVector offset_location = {
         Config::get<double>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.AGENT_SPAWN_OFFSET_LOCATION_X"),
         Config::get<double>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.AGENT_SPAWN_OFFSET_LOCATION_Y"),
         Config::get<double>("SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.AGENT_SPAWN_OFFSET_LOCATION_Z")
     };
-    FVector agent_initial_location = agent_initial_locations_.at(episode_index_) + offset_location;
+
+    FVector agent_initial_location;
+    FVector agent_goal_location;
+    if (episode_bank_) {
+        const EpisodeBankEpisode& episode = episode_bank_->getEpisode(episode_bank_first_episode_index_ + episode_index_);
+        agent_initial_location = {episode.initial_location_[0], episode.initial_location_[1], episode.initial_location_[2]};
+        agent_goal_location = {episode.goal_location_[0], episode.goal_location_[1], episode.goal_location_[2]};
+    } else {
+        agent_initial_location = agent_initial_locations_.at(episode_index_);
+        agent_goal_location = agent_goal_locations_.at(episode_index_);
+    }
+    agent_initial_location += offset_location + AgentInstance::getOffset(agent_index_);
+    agent_goal_location += AgentInstance::getOffset(agent_index_);
 
     bool sweep = false;
     FHitResult* hit_result = nullptr;
     agent_actor_->SetActorLocationAndRotation(
         agent_initial_location, FRotator::ZeroRotator, sweep, hit_result, ETeleportType::TeleportPhysics);
     goal_actor_->SetActorLocationAndRotation(
-        agent_goal_locations_.at(episode_index_), FRotator::ZeroRotator, sweep, hit_result, ETeleportType::TeleportPhysics);
+        agent_goal_location, FRotator::ZeroRotator, sweep, hit_result, ETeleportType::TeleportPhysics);
 
-    if (episode_index_ < agent_goal_locations_.size() - 1) { 
+    if (episode_index_ < num_episodes_ - 1) { 
         episode_index_++;
     }  else {
         episode_index_ = 0;
@@ -230,3 +280,15 @@ bool ImitationLearningTask::isReady() const
 {
     return true;
 }
+
+std::vector<uint8_t> ImitationLearningTask::getResetState() const
+{
+    return Std::reinterpretAsVector<uint8_t, int64_t>({restored_episode_index_ >= 0 ? restored_episode_index_ : episode_index_});
+}
+
+void ImitationLearningTask::setResetState(const std::vector<uint8_t>& reset_state)
+{
+    std::span<const int64_t> episode_index = Std::reinterpretAsSpanOf<const int64_t>(reset_state);
+    SP_ASSERT(episode_index.size() == 1);
+    restored_episode_index_ = episode_index[0];
+}
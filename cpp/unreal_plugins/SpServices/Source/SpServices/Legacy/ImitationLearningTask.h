@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <stdint.h> // uint8_t
+#include <stdint.h> // int64_t, uint8_t, uint64_t
 
 #include <map>
 #include <memory> // std::unique_ptr
@@ -16,6 +16,7 @@
 #include "SpCore/ArrayDesc.h" // TODO: remove
 
 #include "SpServices/Legacy/ActorHitComponent.h"
+#include "SpServices/Legacy/EpisodeBank.h"
 #include "SpServices/Legacy/StandaloneComponent.h"
 #include "SpServices/Legacy/Task.h"
 
@@ -24,7 +25,7 @@ class UWorld;
 
 class ImitationLearningTask : public Task {
 public:
-    ImitationLearningTask(UWorld* world);
+    ImitationLearningTask(UWorld* world, int agent_index);
     ~ImitationLearningTask();
 
     void findObjectReferences(UWorld* world) override;
@@ -39,8 +40,12 @@ public:
     std::map<std::string, std::vector<uint8_t>> getStepInfo() const override;
     void reset() override;
     bool isReady() const override;
+    std::vector<uint8_t> getResetState() const override;
+    void setResetState(const std::vector<uint8_t>& reset_state) override;
 
 private:
+    int agent_index_ = 0;
+
     AActor* agent_actor_ = nullptr;
     AActor* goal_actor_ = nullptr;
     std::vector<AActor*> obstacle_ignore_actors_;
@@ -49,8 +54,15 @@ private:
 
     std::vector<FVector> agent_initial_locations_;
     std::vector<FVector> agent_goal_locations_;
+
+    // only used if SP_SERVICES.LEGACY.IMITATION_LEARNING_TASK.EPISODE_BANK_FILE is set
+    std::unique_ptr<EpisodeBank> episode_bank_ = nullptr;
+    uint64_t episode_bank_first_episode_index_ = 0;
+
     std::string previous_scene_id_ = "";
-    int episode_index_ = -1;
+    int64_t episode_index_ = -1;
+    int64_t restored_episode_index_ = -1; // set by setResetState(...), used instead of episode_index_ on the next reset
+    int64_t num_episodes_ = 0;
     bool hit_goal_ = false;
     bool hit_obstacle_ = false;
 };
@@ -6,12 +6,12 @@
 
 #include <stdint.h> // uint8_t
 
-#include <stdint.h> // uint8_t
-
+#include <algorithm> // std::copy
 #include <map>
-#include <memory>  // std::make_unique
+#include <memory>    // std::make_unique
+#include <mutex>     // std::lock_guard
 #include <string>
-#include <utility> // std::move
+#include <utility>   // std::move
 #include <vector>
 
 #include <Components/PrimitiveComponent.h>
@@ -21,12 +21,15 @@
 #include <GameFramework/Actor.h>
 #include <Math/Rotator.h>
 #include <Math/Vector.h>
+#include <PhysicsEngine/BodyInstance.h> // FBodyInstance, FCalculateCustomPhysics
 #include <PhysicsEngine/PhysicsSettings.h>
 
 #include "SpCore/ArrayDesc.h" // TODO: remove
 #include "SpCore/Assert.h"
 #include "SpCore/Config.h"
+#include "SpCore/Std.h"
 
+#include "SpServices/Legacy/SensorSchedule.h"
 #include "SpServices/Legacy/StandaloneComponent.h"
 #include "SpServices/Legacy/TickComponent.h"
 
@@ -37,6 +40,11 @@ ImuSensor::ImuSensor(UPrimitiveComponent* primitive_component)
     SP_ASSERT(primitive_component);
     primitive_component_ = primitive_component;
 
+    schedule_ = std::make_unique<SensorSchedule>(
+        Config::get<double>("SP_SERVICES.LEGACY.IMU_SENSOR.UPDATE_RATE"),
+        Config::get<bool>("SP_SERVICES.LEGACY.IMU_SENSOR.UPDATE_ON_DEMAND"));
+    SP_ASSERT(schedule_);
+
     tick_component_ = std::make_unique<StandaloneComponent<UTickComponent>>(primitive_component->GetWorld(), "tick_event_component");
     SP_ASSERT(tick_component_);
     SP_ASSERT(tick_component_->component_);
@@ -45,9 +53,22 @@ ImuSensor::ImuSensor(UPrimitiveComponent* primitive_component)
     tick_component_->component_->PrimaryComponentTick.TickGroup = ETickingGroup::TG_PostPhysics;
     tick_component_->component_->setTickFunc([this](float delta_time, ELevelTick level_tick, FActorComponentTickFunction* this_tick_function) -> void {
 
+        double time = primitive_component_->GetWorld()->GetTimeSeconds();
+        if (!schedule_->shouldUpdate(time)) {
+            return;
+        }
+
+        // If we don't update every frame, we need to compute the acceleration over the time since our previous update
+        // rather than over the most recent frame.
+        double update_delta_time = (previous_update_time_ >= 0.0) ? time - previous_update_time_ : delta_time;
+        previous_update_time_ = time;
+
         // Update linear acceleration
         FVector current_linear_velocity_world = primitive_component_->GetPhysicsLinearVelocity();
-        FVector linear_acceleration_world = (current_linear_velocity_world - previous_linear_velocity_world_) / delta_time;
+        FVector linear_acceleration_world = FVector::ZeroVector;
+        if (update_delta_time > 0.0) {
+            linear_acceleration_world = (current_linear_velocity_world - previous_linear_velocity_world_) / update_delta_time;
+        }
 
         // Roughly speaking, an accelerometer measures deviation from freefall. Therefore, a stationary accelerometer will measure a positive
         // acceleration of +9.81 m/s^2, even though it isn't moving. To account for this detail, we get gravitational acceleration from Unreal,
@@ -81,12 +102,46 @@ ImuSensor::ImuSensor(UPrimitiveComponent* primitive_component)
             DrawDebugDirectionalArrow(world, location, location + rotation.RotateVector(angular_velocity_body_), 0.5f, FColor(0, 200, 200), false, 0.033f, 0, 0.5f);
         }
     });
+
+    // Custom physics callbacks are invoked once per physics substep, but they only remain registered for a single
+    // frame, so we register our callback before physics runs on every frame.
+    if (Config::get<bool>("SP_SERVICES.LEGACY.IMU_SENSOR.RECORD_SUBSTEPS")) {
+        int substep_buffer_capacity = Config::get<int>("SP_SERVICES.LEGACY.IMU_SENSOR.SUBSTEP_BUFFER_CAPACITY");
+        SP_ASSERT(substep_buffer_capacity > 0);
+        substep_samples_.resize(static_cast<size_t>(substep_buffer_capacity) * 7);
+
+        calculate_custom_physics_.BindRaw(this, &ImuSensor::recordSubstep);
+
+        substep_tick_component_ = std::make_unique<StandaloneComponent<UTickComponent>>(primitive_component->GetWorld(), "substep_tick_event_component");
+        SP_ASSERT(substep_tick_component_);
+        SP_ASSERT(substep_tick_component_->component_);
+        substep_tick_component_->component_->PrimaryComponentTick.bCanEverTick = true;
+        substep_tick_component_->component_->PrimaryComponentTick.bTickEvenWhenPaused = false;
+        substep_tick_component_->component_->PrimaryComponentTick.TickGroup = ETickingGroup::TG_PrePhysics;
+        substep_tick_component_->component_->setTickFunc([this](float delta_time, ELevelTick level_tick, FActorComponentTickFunction* this_tick_function) -> void {
+            FBodyInstance* body_instance = primitive_component_->GetBodyInstance();
+            SP_ASSERT(body_instance);
+
+            // the world's time has already been advanced to the end of the frame that is about to be simulated
+            substep_time_ = primitive_component_->GetWorld()->GetTimeSeconds() - delta_time;
+            body_instance->AddCustomPhysics(calculate_custom_physics_);
+        });
+    }
 }
 
 ImuSensor::~ImuSensor()
 {
+    if (Config::get<bool>("SP_SERVICES.LEGACY.IMU_SENSOR.RECORD_SUBSTEPS")) {
+        SP_ASSERT(substep_tick_component_);
+        substep_tick_component_ = nullptr;
+        calculate_custom_physics_.Unbind();
+    }
+
     SP_ASSERT(tick_component_);
     tick_component_ = nullptr;
+
+    SP_ASSERT(schedule_);
+    schedule_ = nullptr;
 }
 
 std::map<std::string, ArrayDesc> ImuSensor::getObservationSpace() const
@@ -108,6 +163,22 @@ std::map<std::string, ArrayDesc> ImuSensor::getObservationSpace() const
     array_desc.shape_ = {3};
     Std::insert(observation_space, "imu.angular_velocity_body", std::move(array_desc));
 
+    // simulated time in seconds at which the sensor was most recently updated
+    array_desc.low_ = -1.0;
+    array_desc.high_ = std::numeric_limits<double>::max();
+    array_desc.datatype_ = DataType::Float64;
+    array_desc.shape_ = {1};
+    Std::insert(observation_space, "imu.timestamp", std::move(array_desc));
+
+    // all substep samples recorded since the previous observation, each laid out as (t, a_x, a_y, a_z, g_x, g_y, g_z)
+    if (Config::get<bool>("SP_SERVICES.LEGACY.IMU_SENSOR.RECORD_SUBSTEPS")) {
+        array_desc.low_ = std::numeric_limits<double>::lowest();
+        array_desc.high_ = std::numeric_limits<double>::max();
+        array_desc.datatype_ = DataType::Float64;
+        array_desc.shape_ = {-1, 7};
+        Std::insert(observation_space, "imu.substep_samples", std::move(array_desc));
+    }
+
     return observation_space;
 }
 
@@ -125,5 +196,70 @@ std::map<std::string, std::vector<uint8_t>> ImuSensor::getObservation() const
         angular_velocity_body_.Y,
         angular_velocity_body_.Z}));
 
+    Std::insert(observation, "imu.timestamp", Std::reinterpretAsVector<uint8_t, double>({schedule_->update_time_}));
+
+    if (Config::get<bool>("SP_SERVICES.LEGACY.IMU_SENSOR.RECORD_SUBSTEPS")) {
+        std::vector<double> substep_samples;
+        {
+            std::lock_guard<std::mutex> lock(substep_samples_mutex_);
+            int capacity = substep_samples_.size() / 7;
+            substep_samples.resize(static_cast<size_t>(num_substep_samples_) * 7);
+            for (int i = 0; i < num_substep_samples_; i++) {
+                int src_index = (substep_samples_begin_ + i) % capacity;
+                std::copy(substep_samples_.begin() + 7*src_index, substep_samples_.begin() + 7*(src_index + 1), substep_samples.begin() + 7*i);
+            }
+            substep_samples_begin_ = 0;
+            num_substep_samples_ = 0;
+        }
+        Std::insert(observation, "imu.substep_samples", Std::reinterpretAsVectorOf<uint8_t>(substep_samples));
+    }
+
     return observation;
 }
+
+void ImuSensor::requestUpdate()
+{
+    schedule_->requestUpdate();
+}
+
+void ImuSensor::recordSubstep(float delta_time, FBodyInstance* body_instance)
+{
+    SP_ASSERT(body_instance);
+
+    substep_time_ += delta_time;
+
+    FTransform transform = body_instance->GetUnrealWorldTransform_AssumesLocked();
+    FVector linear_velocity_world = body_instance->GetUnrealWorldVelocity_AssumesLocked();
+    FVector angular_velocity_world = body_instance->GetUnrealWorldAngularVelocityInRadians_AssumesLocked();
+
+    FVector linear_acceleration_world = FVector::ZeroVector;
+    if (substep_previous_linear_velocity_world_valid_ && delta_time > 0.0f) {
+        linear_acceleration_world = (linear_velocity_world - substep_previous_linear_velocity_world_) / delta_time;
+    }
+    substep_previous_linear_velocity_world_ = linear_velocity_world;
+    substep_previous_linear_velocity_world_valid_ = true;
+
+    // see the comment in our tick function above, but here we only subtract gravity from the world-space z component
+    float gravity_world = UPhysicsSettings::Get()->DefaultGravityZ;
+    FVector linear_acceleration_body = transform.GetRotation().UnrotateVector(linear_acceleration_world - FVector(0.0, 0.0, gravity_world));
+    FVector angular_velocity_body = transform.GetRotation().UnrotateVector(angular_velocity_world);
+
+    std::lock_guard<std::mutex> lock(substep_samples_mutex_);
+
+    // if the buffer is full, overwrite the oldest sample
+    int capacity = substep_samples_.size() / 7;
+    if (num_substep_samples_ == capacity) {
+        substep_samples_begin_ = (substep_samples_begin_ + 1) % capacity;
+        num_substep_samples_--;
+    }
+
+    double* sample = substep_samples_.data() + 7*((substep_samples_begin_ + num_substep_samples_) % capacity);
+    sample[0] = substep_time_;
+    sample[1] = linear_acceleration_body.X;
+    sample[2] = linear_acceleration_body.Y;
+    sample[3] = linear_acceleration_body.Z;
+    sample[4] = angular_velocity_body.X;
+    sample[5] = angular_velocity_body.Y;
+    sample[6] = angular_velocity_body.Z;
+    num_substep_samples_++;
+}
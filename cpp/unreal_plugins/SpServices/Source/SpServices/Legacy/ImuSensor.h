@@ -8,17 +8,21 @@
 
 #include <map>
 #include <memory> // std::unique_ptr
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include <Math/Vector.h>
+#include <PhysicsEngine/BodyInstance.h> // FCalculateCustomPhysics
 
 #include "SpCore/ArrayDesc.h" // TODO: remove
 
+#include "SpServices/Legacy/SensorSchedule.h"
 #include "SpServices/Legacy/StandaloneComponent.h"
 #include "SpServices/Legacy/TickComponent.h"
 
 class UPrimitiveComponent;
+struct FBodyInstance;
 
 class ImuSensor 
 {
@@ -31,6 +35,9 @@ public:
     std::map<std::string, ArrayDesc> getObservationSpace() const;
     std::map<std::string, std::vector<uint8_t>> getObservation() const;
 
+    // Updates the sensor on the next frame if SP_SERVICES.LEGACY.IMU_SENSOR.UPDATE_ON_DEMAND is set to True.
+    void requestUpdate();
+
     // Linear acceleration minus gravity (i.e., will report +980 cm/s^2 for a stationary body aligned with the world-frame origin) in the body frame in cm/s^2.
     FVector linear_acceleration_body_ = FVector::ZeroVector;
 
@@ -40,6 +47,25 @@ public:
 private:
     UPrimitiveComponent* primitive_component_ = nullptr;
     std::unique_ptr<StandaloneComponent<UTickComponent>> tick_component_ = nullptr;
+    std::unique_ptr<SensorSchedule> schedule_ = nullptr;
 
     FVector previous_linear_velocity_world_ = FVector::ZeroVector;
+    double previous_update_time_ = -1.0;
+
+    // only used if SP_SERVICES.LEGACY.IMU_SENSOR.RECORD_SUBSTEPS is set to True
+    void recordSubstep(float delta_time, FBodyInstance* body_instance);
+
+    std::unique_ptr<StandaloneComponent<UTickComponent>> substep_tick_component_ = nullptr;
+    FCalculateCustomPhysics calculate_custom_physics_;
+    double substep_time_ = 0.0;
+    FVector substep_previous_linear_velocity_world_ = FVector::ZeroVector;
+    bool substep_previous_linear_velocity_world_valid_ = false;
+
+    // Fixed-capacity ring buffer of samples, each laid out as (t, a_x, a_y, a_z, g_x, g_y, g_z). Depending on how
+    // physics is configured, recordSubstep(...) might be called from the physics thread, so we guard the buffer with
+    // a mutex. getObservation() removes all samples from the buffer, so its state is mutable.
+    mutable std::mutex substep_samples_mutex_;
+    mutable std::vector<double> substep_samples_;
+    mutable int substep_samples_begin_ = 0;
+    mutable int num_substep_samples_ = 0;
 };
@@ -0,0 +1,209 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/LidarSensor.h"
+
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <algorithm> // std::max, std::min
+#include <limits>    // std::numeric_limits
+#include <map>
+#include <random>    // std::minstd_rand, std::normal_distribution
+#include <string>
+#include <utility>   // std::move
+#include <vector>
+
+#include <Async/ParallelFor.h>
+#include <CollisionQueryParams.h>   // FCollisionQueryParams
+#include <Components/SceneComponent.h>
+#include <Engine/EngineTypes.h>     // ECollisionChannel, FHitResult
+#include <Engine/World.h>
+#include <GameFramework/Actor.h>
+#include <HAL/Platform.h>           // int32
+#include <Math/Transform.h>
+#include <Math/UnrealMathUtility.h> // FMath
+#include <Math/Vector.h>
+
+#include "SpCore/ArrayDesc.h" // TODO: remove
+#include "SpCore/Assert.h"
+#include "SpCore/Boost.h"
+#include "SpCore/Config.h"
+#include "SpCore/SharedMemoryRegion.h"
+#include "SpCore/Std.h"
+#include "SpCore/Unreal.h"
+
+// number of rays traced by each ParallelFor task, large enough to amortize the cost of scheduling a task
+const int NUM_RAYS_PER_BATCH = 256;
+
+LidarSensor::LidarSensor(USceneComponent* scene_component, const std::string& name)
+{
+    SP_ASSERT(scene_component);
+    SP_ASSERT(scene_component->GetOwner());
+    scene_component_ = scene_component;
+    name_ = name;
+
+    int num_channels = Config::get<int>("SP_SERVICES.LEGACY.LIDAR_SENSOR.NUM_CHANNELS");
+    int num_azimuth_steps = Config::get<int>("SP_SERVICES.LEGACY.LIDAR_SENSOR.NUM_AZIMUTH_STEPS");
+    double min_elevation = Config::get<double>("SP_SERVICES.LEGACY.LIDAR_SENSOR.MIN_ELEVATION");
+    double max_elevation = Config::get<double>("SP_SERVICES.LEGACY.LIDAR_SENSOR.MAX_ELEVATION");
+    double min_azimuth = Config::get<double>("SP_SERVICES.LEGACY.LIDAR_SENSOR.MIN_AZIMUTH");
+    double max_azimuth = Config::get<double>("SP_SERVICES.LEGACY.LIDAR_SENSOR.MAX_AZIMUTH");
+    SP_ASSERT(num_channels > 0);
+    SP_ASSERT(num_azimuth_steps > 0);
+    SP_ASSERT(min_elevation <= max_elevation);
+    SP_ASSERT(min_azimuth <= max_azimuth);
+
+    // If the azimuth range covers a full revolution, we don't want the first and last columns to coincide, so we
+    // divide the range into num_azimuth_steps intervals instead of num_azimuth_steps - 1 intervals.
+    bool full_revolution = max_azimuth - min_azimuth >= 360.0;
+    double azimuth_step = (full_revolution || num_azimuth_steps == 1) ?
+        (max_azimuth - min_azimuth) / num_azimuth_steps : (max_azimuth - min_azimuth) / (num_azimuth_steps - 1);
+    double elevation_step = (num_channels == 1) ? 0.0 : (max_elevation - min_elevation) / (num_channels - 1);
+
+    // rays are ordered by channel, then by azimuth step
+    for (int i = 0; i < num_channels; i++) {
+        double elevation = FMath::DegreesToRadians(min_elevation + i*elevation_step);
+        for (int j = 0; j < num_azimuth_steps; j++) {
+            double azimuth = FMath::DegreesToRadians(min_azimuth + j*azimuth_step);
+            ray_directions_.push_back(FVector(
+                FMath::Cos(elevation) * FMath::Cos(azimuth),
+                FMath::Cos(elevation) * FMath::Sin(azimuth),
+                FMath::Sin(elevation)));
+        }
+    }
+
+    num_bytes_ = ray_directions_.size() * 4 * sizeof(float);
+
+    minstd_rand_ = std::minstd_rand(Config::get<int>("SP_SERVICES.LEGACY.LIDAR_SENSOR.RANDOM_SEED"));
+
+    // create shared_memory_object
+    if (Config::get<bool>("SP_SERVICES.LEGACY.LIDAR_SENSOR.USE_SHARED_MEMORY")) {
+        // use a unique ID rather than a name derived from the actor, so sensors on different agents don't collide, and
+        // so the name doesn't exceed the 31-character limit on macOS
+        shared_memory_id_ = SharedMemoryRegion::getUniqueIdString(SharedMemoryRegion::getUniqueId());
+
+        #if BOOST_OS_WINDOWS
+            shared_memory_name_ = shared_memory_id_; // ID doesn't have a leading slash on Windows
+            boost::interprocess::windows_shared_memory windows_shared_memory(
+                boost::interprocess::create_only,
+                shared_memory_id_.c_str(),
+                boost::interprocess::read_write,
+                num_bytes_);
+            shared_memory_mapped_region_ = boost::interprocess::mapped_region(windows_shared_memory, boost::interprocess::read_write);
+        #elif BOOST_OS_MACOS || BOOST_OS_LINUX
+            shared_memory_name_ = shared_memory_id_.substr(1); // ID has a leading slash on macOS and Linux, but the externally visible name doesn't
+            boost::interprocess::shared_memory_object::remove(shared_memory_id_.c_str());
+            boost::interprocess::shared_memory_object shared_memory_object(
+                boost::interprocess::create_only,
+                shared_memory_id_.c_str(),
+                boost::interprocess::read_write);
+            shared_memory_object.truncate(num_bytes_);
+            shared_memory_mapped_region_ = boost::interprocess::mapped_region(shared_memory_object, boost::interprocess::read_write);
+        #else
+            #error
+        #endif
+
+        SharedMemoryRegion::applyFlags(shared_memory_mapped_region_, SharedMemoryRegion::getGlobalFlags());
+    }
+}
+
+LidarSensor::~LidarSensor()
+{
+    if (Config::get<bool>("SP_SERVICES.LEGACY.LIDAR_SENSOR.USE_SHARED_MEMORY")) {
+        #if BOOST_OS_MACOS || BOOST_OS_LINUX
+            boost::interprocess::shared_memory_object::remove(shared_memory_id_.c_str());
+        #endif
+    }
+
+    SP_ASSERT(scene_component_);
+    scene_component_ = nullptr;
+}
+
+std::map<std::string, ArrayDesc> LidarSensor::getObservationSpace() const
+{
+    std::map<std::string, ArrayDesc> observation_space;
+
+    // x, y, z in [cm] in the sensor frame, intensity in [0, 1]
+    ArrayDesc array_desc;
+    array_desc.low_ = std::numeric_limits<float>::lowest();
+    array_desc.high_ = std::numeric_limits<float>::max();
+    array_desc.shape_ = {static_cast<int64_t>(ray_directions_.size()), 4};
+    array_desc.datatype_ = DataType::Float32;
+    array_desc.use_shared_memory_ = Config::get<bool>("SP_SERVICES.LEGACY.LIDAR_SENSOR.USE_SHARED_MEMORY");
+    array_desc.shared_memory_name_ = shared_memory_name_;
+    Std::insert(observation_space, name_ + ".points", std::move(array_desc));
+
+    return observation_space;
+}
+
+std::map<std::string, std::vector<uint8_t>> LidarSensor::getObservation() const
+{
+    std::map<std::string, std::vector<uint8_t>> observation;
+
+    float* dest_ptr = nullptr;
+    if (Config::get<bool>("SP_SERVICES.LEGACY.LIDAR_SENSOR.USE_SHARED_MEMORY")) {
+        dest_ptr = static_cast<float*>(shared_memory_mapped_region_.get_address());
+    } else {
+        Std::insert(observation, name_ + ".points", {});
+        observation.at(name_ + ".points").resize(num_bytes_);
+        dest_ptr = reinterpret_cast<float*>(observation.at(name_ + ".points").data());
+    }
+    SP_ASSERT(dest_ptr);
+
+    UWorld* world = scene_component_->GetWorld();
+    SP_ASSERT(world);
+
+    double min_range = Config::get<double>("SP_SERVICES.LEGACY.LIDAR_SENSOR.MIN_RANGE");
+    double max_range = Config::get<double>("SP_SERVICES.LEGACY.LIDAR_SENSOR.MAX_RANGE");
+    double noise_std_dev = Config::get<double>("SP_SERVICES.LEGACY.LIDAR_SENSOR.NOISE_STD_DEV");
+    SP_ASSERT(0.0 <= min_range && min_range < max_range);
+    SP_ASSERT(noise_std_dev >= 0.0);
+
+    // We draw the range noise for all rays up front on the game thread, so the noise is deterministic for a given
+    // seed no matter how the rays are distributed across worker threads.
+    std::vector<double> range_noise(ray_directions_.size(), 0.0);
+    if (noise_std_dev > 0.0) {
+        std::normal_distribution<double> normal_distribution(0.0, noise_std_dev);
+        for (auto& noise : range_noise) {
+            noise = normal_distribution(minstd_rand_);
+        }
+    }
+
+    FTransform transform = scene_component_->GetComponentTransform();
+    FVector start = transform.GetLocation();
+
+    // don't return hits against the actor the sensor is attached to
+    FCollisionQueryParams collision_query_params(Unreal::toFName("lidar_sensor"), false, scene_component_->GetOwner());
+    ECollisionChannel collision_channel = ECollisionChannel::ECC_Visibility;
+
+    int num_rays = ray_directions_.size();
+    int num_batches = (num_rays + NUM_RAYS_PER_BATCH - 1) / NUM_RAYS_PER_BATCH;
+
+    ParallelFor(num_batches, [this, world, &transform, &start, &collision_query_params, collision_channel, &range_noise, min_range, max_range, num_rays, dest_ptr](int32 batch_index) -> void {
+        int ray_begin = batch_index * NUM_RAYS_PER_BATCH;
+        int ray_end = std::min(ray_begin + NUM_RAYS_PER_BATCH, num_rays);
+        for (int i = ray_begin; i < ray_end; i++) {
+            FVector direction_world = transform.TransformVectorNoScale(ray_directions_.at(i));
+            FVector end = start + max_range * direction_world;
+
+            float* point = dest_ptr + 4*i;
+            point[0] = 0.0f;
+            point[1] = 0.0f;
+            point[2] = 0.0f;
+            point[3] = 0.0f;
+
+            FHitResult hit_result;
+            if (world->LineTraceSingleByChannel(hit_result, start, end, collision_channel, collision_query_params) && hit_result.Distance >= min_range) {
+                double range = std::max(hit_result.Distance + range_noise.at(i), 0.0);
+                FVector point_sensor = range * ray_directions_.at(i);
+                point[0] = point_sensor.X;
+                point[1] = point_sensor.Y;
+                point[2] = point_sensor.Z;
+                point[3] = std::max(FVector::DotProduct(-direction_world, hit_result.ImpactNormal), 0.0);
+            }
+        }
+    });
+
+    return observation;
+}
@@ -0,0 +1,52 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <map>
+#include <random> // std::minstd_rand
+#include <string>
+#include <vector>
+
+#include <Math/Vector.h>
+
+#include "SpCore/ArrayDesc.h" // TODO: remove
+#include "SpCore/Boost.h"
+
+class USceneComponent;
+
+// A LidarSensor casts a fixed pattern of rays against the physics scene, so it works without rendering. The pattern
+// consists of NUM_CHANNELS rows evenly spaced in elevation, and NUM_AZIMUTH_STEPS columns evenly spaced in azimuth,
+// expressed in the frame of the scene component the sensor is attached to. Each ray produces one (x, y, z, intensity)
+// point in the sensor frame in cm, where intensity is the cosine of the angle between the ray and the surface normal,
+// and is 0 if the ray didn't hit anything (in which case x, y, and z are also 0). Rays are traced in parallel on the
+// task graph, so the cost of the sensor scales with the number of available CPU cores.
+class LidarSensor
+{
+public:
+    LidarSensor() = delete;
+    LidarSensor(USceneComponent* scene_component, const std::string& name = "lidar"); // prefix for observation names and shared memory names
+    ~LidarSensor();
+
+    // Used by Agents.
+    std::map<std::string, ArrayDesc> getObservationSpace() const;
+    std::map<std::string, std::vector<uint8_t>> getObservation() const;
+
+private:
+    USceneComponent* scene_component_ = nullptr;
+    std::string name_;
+
+    // unit-length ray directions in the sensor frame
+    std::vector<FVector> ray_directions_;
+
+    uint64_t num_bytes_ = 0;
+    mutable std::minstd_rand minstd_rand_;
+
+    // only used if SP_SERVICES.LEGACY.LIDAR_SENSOR.USE_SHARED_MEMORY is set to True
+    std::string shared_memory_name_; // externally visible name
+    std::string shared_memory_id_;   // ID used to manage the shared memory resource internally
+    boost::interprocess::mapped_region shared_memory_mapped_region_;
+};
@@ -4,23 +4,52 @@
 
 #include "SpServices/Legacy/NavMesh.h"
 
-#include <stdint.h> // uint8_t
+#include <stdint.h> // int32_t, int64_t, uint8_t, uint64_t
+#include <string.h> // memcmp
+
+#include <algorithm>  // std::min, std::swap, std::upper_bound
+#include <cmath>      // std::floor, std::sqrt
+#include <filesystem> // std::filesystem::create_directories, std::filesystem::exists, std::filesystem::path, std::filesystem::remove, std::filesystem::rename
+#include <fstream>    // std::ifstream, std::ofstream
+#include <functional> // std::greater
+#include <limits>     // std::numeric_limits
+#include <map>
+#include <queue>      // std::priority_queue, std::queue
+#include <random>     // std::minstd_rand
 #include <string>
+#include <system_error> // std::error_code
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>    // std::make_pair, std::move, std::pair
 #include <vector>
 
 #include <AI/NavDataGenerator.h>           // FNavDataGenerator::ExportNavigationData
 #include <AI/Navigation/NavigationTypes.h> // FNavAgentProperties, FNavLocation
+#include <Async/ParallelFor.h>
 #include <Containers/Array.h>
+#include <Detour/DetourAlloc.h>            // dtAlloc, dtFree
+#include <Detour/DetourNavMesh.h>          // dtAllocNavMesh, dtFreeNavMesh, dtMeshTile, dtNavMesh, dtNavMeshParams
+#include <Detour/DetourStatus.h>           // dtStatusSucceed
+#include <HAL/Platform.h>                  // int32
+#include <HAL/PlatformProcess.h>           // FPlatformProcess
+#include <Hash/CityHash.h>                 // CityHash64
+#include <Math/UnrealMathUtility.h>        // FMath
+#include <Math/Vector.h>
 #include <Misc/Build.h>                    // UE_BUILD_SHIPPING, UE_BUILD_TEST
+#include <Misc/EngineVersion.h>
 #include <NavigationData.h>                // FPathFindingResult
 #include <NavigationSystem.h>
 #include <NavigationSystemTypes.h>         // FPathFindingQuery
+#include <NavMesh/PImplRecastNavMesh.h>    // FPImplRecastNavMesh
 #include <NavMesh/RecastNavMesh.h>
 #include <Templates/Casts.h>
+#include <UObject/Package.h>               // UPackage
 
 #include "SpCore/Assert.h"
+#include "SpCore/Boost.h"
 #include "SpCore/Config.h"
 #include "SpCore/Log.h"
+#include "SpCore/Std.h"
 #include "SpCore/Unreal.h"
 
 void NavMesh::findObjectReferences(UWorld* world)
@@ -83,9 +112,32 @@ void NavMesh::findObjectReferences(UWorld* world)
     recast_nav_mesh_->NavMeshResolutionParams[static_cast<uint8>(ENavigationDataResolution::High)].CellSize = cell_size;
     recast_nav_mesh_->NavMeshResolutionParams[static_cast<uint8>(ENavigationDataResolution::High)].CellHeight = cell_height;
 
-    SP_LOG("Building navigation mesh...");
+    std::string cache_file = "";
+    if (Config::isInitialized() && Config::get<std::string>("SP_SERVICES.LEGACY.NAVMESH.CACHE_DIR") != "") {
+        cache_file = (std::filesystem::path(Config::get<std::string>("SP_SERVICES.LEGACY.NAVMESH.CACHE_DIR")) / ("navmesh_" + getCacheKey() + ".bin")).string();
+    }
+
+    if (cache_file != "" && loadFromCache(cache_file)) {
+        SP_LOG("Loaded navigation mesh from cache: ", cache_file);
+
+        // prevent the navigation system from rebuilding the tiles we just loaded, auto-update is enabled again in
+        // cleanUpObjectReferences() so it doesn't stay disabled for subsequent worlds
+        UNavigationSystemV1::SetNavigationAutoUpdateEnabled(false, navigation_system_v1_);
+        navigation_auto_update_disabled_ = true;
+
+    } else {
+        SP_LOG("Building navigation mesh...");
+
+        navigation_system_v1_->Build();
 
-    navigation_system_v1_->Build();
+        if (cache_file != "") {
+            SP_LOG("Saving navigation mesh to cache: ", cache_file);
+            saveToCache(cache_file);
+        }
+    }
+
+    // the navigation mesh might have changed, so triangles will be recomputed the next time they're needed
+    triangles_.clear();
 
     // We need to wrap this call with guards because ExportNavigationData(...) is only implemented in non-shipping builds, see:
     //     Engine/Source/Runtime/Engine/Public/AI/NavDataGenerator.h
@@ -105,9 +157,157 @@ void NavMesh::findObjectReferences(UWorld* world)
 #endif
 }
 
+// must be incremented whenever the layout of cache files changes
+const uint32_t CACHE_FILE_VERSION = 1;
+const char CACHE_FILE_MAGIC[8] = {'S', 'P', 'N', 'A', 'V', 'M', 'S', 'H'};
+
+std::string NavMesh::getCacheKey() const
+{
+    const FNavMeshResolutionParam& resolution_params = recast_nav_mesh_->NavMeshResolutionParams[static_cast<uint8>(ENavigationDataResolution::Default)];
+
+    std::string key_str =
+        "world="                    + Unreal::toStdString(world_->GetOutermost()->GetName()) + ";" +
+        "engine_version="           + Unreal::toStdString(FEngineVersion::Current().ToString()) + ";" +
+        "cache_file_version="       + std::to_string(CACHE_FILE_VERSION) + ";" +
+        "tile_pool_size="           + std::to_string(recast_nav_mesh_->TilePoolSize) + ";" +
+        "tile_size_uu="             + std::to_string(recast_nav_mesh_->TileSizeUU) + ";" +
+        "cell_size="                + std::to_string(resolution_params.CellSize) + ";" +
+        "cell_height="              + std::to_string(resolution_params.CellHeight) + ";" +
+        "agent_radius="             + std::to_string(recast_nav_mesh_->AgentRadius) + ";" +
+        "agent_height="             + std::to_string(recast_nav_mesh_->AgentHeight) + ";" +
+        "agent_max_slope="          + std::to_string(recast_nav_mesh_->AgentMaxSlope) + ";" +
+        "agent_max_step_height="    + std::to_string(recast_nav_mesh_->AgentMaxStepHeight) + ";" +
+        "min_region_area="          + std::to_string(recast_nav_mesh_->MinRegionArea) + ";" +
+        "merge_region_size="        + std::to_string(recast_nav_mesh_->MergeRegionSize) + ";" +
+        "max_simplification_error=" + std::to_string(recast_nav_mesh_->MaxSimplificationError);
+
+    return (boost::format("%016x") % CityHash64(key_str.data(), key_str.size())).str();
+}
+
+bool NavMesh::loadFromCache(const std::string& cache_file)
+{
+    if (!std::filesystem::exists(cache_file)) {
+        return false;
+    }
+
+    std::ifstream fs(cache_file, std::ios::binary);
+    SP_ASSERT(fs.is_open());
+
+    char magic[8];
+    uint32_t version = 0;
+    dtNavMeshParams nav_mesh_params;
+    int32_t num_tiles = 0;
+    fs.read(magic, sizeof(magic));
+    fs.read(reinterpret_cast<char*>(&version), sizeof(version));
+    fs.read(reinterpret_cast<char*>(&nav_mesh_params), sizeof(nav_mesh_params));
+    fs.read(reinterpret_cast<char*>(&num_tiles), sizeof(num_tiles));
+    if (!fs.good() || memcmp(magic, CACHE_FILE_MAGIC, sizeof(magic)) != 0 || version != CACHE_FILE_VERSION) {
+        SP_LOG("WARNING: Ignoring invalid navigation mesh cache file: ", cache_file);
+        return false;
+    }
+
+    dtNavMesh* detour_nav_mesh = dtAllocNavMesh();
+    SP_ASSERT(detour_nav_mesh);
+    dtStatus status = detour_nav_mesh->init(&nav_mesh_params);
+    if (!dtStatusSucceed(status)) {
+        SP_LOG("WARNING: Ignoring invalid navigation mesh cache file: ", cache_file);
+        dtFreeNavMesh(detour_nav_mesh);
+        return false;
+    }
+
+    // a truncated or corrupt cache file is not an error, we release everything we allocated and let the caller rebuild
+    for (int i = 0; i < num_tiles; i++) {
+        int32_t tile_num_bytes = 0;
+        fs.read(reinterpret_cast<char*>(&tile_num_bytes), sizeof(tile_num_bytes));
+        if (!fs.good() || tile_num_bytes <= 0) {
+            SP_LOG("WARNING: Ignoring truncated navigation mesh cache file: ", cache_file);
+            dtFreeNavMesh(detour_nav_mesh);
+            return false;
+        }
+
+        // Detour takes ownership of the tile data because of DT_TILE_FREE_DATA, so it must be allocated with dtAlloc,
+        // but only if addTile(...) succeeds, so we need to free it ourselves otherwise
+        unsigned char* tile_data = static_cast<unsigned char*>(dtAlloc(tile_num_bytes, DT_ALLOC_PERM_TILE_DATA));
+        SP_ASSERT(tile_data);
+        fs.read(reinterpret_cast<char*>(tile_data), tile_num_bytes);
+        if (!fs.good()) {
+            SP_LOG("WARNING: Ignoring truncated navigation mesh cache file: ", cache_file);
+            dtFree(tile_data);
+            dtFreeNavMesh(detour_nav_mesh);
+            return false;
+        }
+
+        status = detour_nav_mesh->addTile(tile_data, tile_num_bytes, DT_TILE_FREE_DATA, 0, nullptr);
+        if (!dtStatusSucceed(status)) {
+            SP_LOG("WARNING: Ignoring corrupt navigation mesh cache file: ", cache_file);
+            dtFree(tile_data);
+            dtFreeNavMesh(detour_nav_mesh);
+            return false;
+        }
+    }
+
+    // FPImplRecastNavMesh takes ownership of detour_nav_mesh and releases the previous one
+    recast_nav_mesh_->GetRecastNavMeshImpl()->SetRecastMesh(detour_nav_mesh);
+    recast_nav_mesh_->RequestDrawingUpdate();
+
+    return true;
+}
+
+void NavMesh::saveToCache(const std::string& cache_file) const
+{
+    const dtNavMesh* detour_nav_mesh = recast_nav_mesh_->GetRecastMesh();
+    SP_ASSERT(detour_nav_mesh);
+
+    // collect non-empty tiles first, because the header needs to store the number of tiles
+    std::vector<const dtMeshTile*> tiles;
+    for (int i = 0; i < detour_nav_mesh->getMaxTiles(); i++) {
+        const dtMeshTile* tile = detour_nav_mesh->getTile(i);
+        if (tile && tile->header && tile->dataSize > 0) {
+            tiles.push_back(tile);
+        }
+    }
+
+    std::filesystem::create_directories(std::filesystem::path(cache_file).parent_path());
+
+    // write to a temporary file and rename it, so other instances never load a partially written cache file, and
+    // include the process ID in the temporary file name, so instances that save at the same time don't collide
+    std::string tmp_cache_file = cache_file + "." + Std::toString(FPlatformProcess::GetCurrentProcessId()) + ".tmp";
+    {
+        std::ofstream fs(tmp_cache_file, std::ios::binary);
+        SP_ASSERT(fs.is_open());
+
+        int32_t num_tiles = static_cast<int32_t>(tiles.size());
+        fs.write(CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+        fs.write(reinterpret_cast<const char*>(&CACHE_FILE_VERSION), sizeof(CACHE_FILE_VERSION));
+        fs.write(reinterpret_cast<const char*>(detour_nav_mesh->getParams()), sizeof(dtNavMeshParams));
+        fs.write(reinterpret_cast<const char*>(&num_tiles), sizeof(num_tiles));
+        for (auto tile : tiles) {
+            int32_t tile_num_bytes = tile->dataSize;
+            fs.write(reinterpret_cast<const char*>(&tile_num_bytes), sizeof(tile_num_bytes));
+            fs.write(reinterpret_cast<const char*>(tile->data), tile_num_bytes);
+        }
+        SP_ASSERT(fs.good());
+    }
+
+    // if another instance is holding cache_file open (e.g., on Windows), the rename can fail, in which case we keep
+    // the navigation mesh we built and leave the cache file to be written by a subsequent run
+    std::error_code error_code;
+    std::filesystem::rename(tmp_cache_file, cache_file, error_code);
+    if (error_code) {
+        SP_LOG("WARNING: Couldn't rename ", tmp_cache_file, " to ", cache_file, ": ", error_code.message());
+        std::filesystem::remove(tmp_cache_file, error_code);
+    }
+}
+
 void NavMesh::cleanUpObjectReferences()
 {
+    geodesic_distance_fields_.clear();
+    triangles_.clear();
     recast_nav_mesh_ = nullptr;
+    if (navigation_auto_update_disabled_) {
+        UNavigationSystemV1::SetNavigationAutoUpdateEnabled(true, navigation_system_v1_);
+        navigation_auto_update_disabled_ = false;
+    }
     navigation_system_v1_ = nullptr;
     world_ = nullptr;
 }
@@ -177,3 +377,322 @@ std::vector<std::vector<double>> NavMesh::getPaths(const std::vector<double>& in
 
     return paths;
 }
+
+std::map<std::string, std::vector<uint8_t>> NavMesh::getPathsPacked(const std::vector<double>& initial_points, const std::vector<double>& goal_points)
+{
+    SP_ASSERT(initial_points.size() == goal_points.size());
+    SP_ASSERT(initial_points.size() % 3 == 0);
+
+    int num_paths = initial_points.size() / 3;
+
+    // Queries are created on the game thread, because creating them accesses the navigation system. Once created,
+    // ANavigationData::FindPath(...) only reads from the navigation mesh, and allocates its own dtNavMeshQuery for
+    // each call, which is also how Unreal's asynchronous path finding executes queries on worker threads.
+    std::vector<FPathFindingQuery> path_finding_queries;
+    path_finding_queries.reserve(num_paths);
+    for (int i = 0; i < num_paths; i++) {
+        FVector initial_point = {initial_points.at(3*i), initial_points.at(3*i + 1), initial_points.at(3*i + 2)};
+        FVector goal_point = {goal_points.at(3*i), goal_points.at(3*i + 1), goal_points.at(3*i + 2)};
+        path_finding_queries.push_back(FPathFindingQuery(world_, *recast_nav_mesh_, initial_point, goal_point));
+    }
+
+    std::vector<TArray<FNavPathPoint>> nav_path_points(num_paths);
+    std::vector<uint8_t> statuses(num_paths, PATH_STATUS_FAILURE);
+    std::vector<double> lengths(num_paths, 0.0);
+
+    const FNavAgentProperties& nav_agent_properties = recast_nav_mesh_->GetConfig();
+    ParallelFor(num_paths, [this, &path_finding_queries, &nav_agent_properties, &nav_path_points, &statuses, &lengths](int32 i) -> void {
+        FPathFindingResult path_finding_result = recast_nav_mesh_->FindPath(nav_agent_properties, path_finding_queries.at(i));
+        if (!path_finding_result.IsSuccessful() || !path_finding_result.Path.IsValid()) {
+            return;
+        }
+        nav_path_points.at(i) = path_finding_result.Path->GetPathPoints();
+        statuses.at(i) = path_finding_result.IsPartial() ? PATH_STATUS_PARTIAL : PATH_STATUS_SUCCESS;
+        lengths.at(i) = path_finding_result.Path->GetLength();
+    });
+
+    std::vector<int64_t> offsets(num_paths + 1, 0);
+    for (int i = 0; i < num_paths; i++) {
+        offsets.at(i + 1) = offsets.at(i) + nav_path_points.at(i).Num();
+    }
+
+    std::vector<double> points(3*offsets.at(num_paths));
+    for (int i = 0; i < num_paths; i++) {
+        double* dest = points.data() + 3*offsets.at(i);
+        for (auto& nav_path_point : nav_path_points.at(i)) {
+            *dest++ = nav_path_point.Location.X;
+            *dest++ = nav_path_point.Location.Y;
+            *dest++ = nav_path_point.Location.Z;
+        }
+    }
+
+    std::map<std::string, std::vector<uint8_t>> packed_paths;
+    Std::insert(packed_paths, "points", Std::reinterpretAsVectorOf<uint8_t>(points));
+    Std::insert(packed_paths, "offsets", Std::reinterpretAsVectorOf<uint8_t>(offsets));
+    Std::insert(packed_paths, "statuses", std::move(statuses));
+    Std::insert(packed_paths, "lengths", Std::reinterpretAsVectorOf<uint8_t>(lengths));
+    return packed_paths;
+}
+
+GeodesicDistanceField NavMesh::computeGeodesicDistanceField(const FVector& goal_point) const
+{
+    GeodesicDistanceField geodesic_distance_field;
+    geodesic_distance_field.goal_point_ = goal_point;
+
+    NavNodeRef goal_poly = recast_nav_mesh_->FindNearestPoly(goal_point, recast_nav_mesh_->GetConfig().DefaultQueryExtent);
+    if (goal_poly == INVALID_NAVNODEREF) {
+        return geodesic_distance_field;
+    }
+
+    // min-heap of (distance, polygon ref), polygons can be pushed more than once, so we skip stale entries
+    std::priority_queue<std::pair<double, uint64_t>, std::vector<std::pair<double, uint64_t>>, std::greater<std::pair<double, uint64_t>>> queue;
+
+    geodesic_distance_field.distances_[goal_poly] = 0.0;
+    geodesic_distance_field.anchor_points_[goal_poly] = goal_point;
+    queue.push(std::make_pair(0.0, goal_poly));
+
+    TArray<FNavigationPortalEdge> portal_edges;
+    while (!queue.empty()) {
+        auto [distance, poly] = queue.top();
+        queue.pop();
+        if (distance > geodesic_distance_field.distances_.at(poly)) {
+            continue;
+        }
+
+        FVector anchor_point = geodesic_distance_field.anchor_points_.at(poly);
+
+        portal_edges.Reset();
+        recast_nav_mesh_->GetPolyNeighbors(poly, portal_edges);
+        for (auto& portal_edge : portal_edges) {
+            FVector portal_point = FMath::ClosestPointOnSegment(anchor_point, portal_edge.Left, portal_edge.Right);
+            double neighbor_distance = distance + FVector::Distance(anchor_point, portal_point);
+
+            auto distance_itr = geodesic_distance_field.distances_.find(portal_edge.ToRef);
+            if (distance_itr == geodesic_distance_field.distances_.end() || neighbor_distance < distance_itr->second) {
+                geodesic_distance_field.distances_[portal_edge.ToRef] = neighbor_distance;
+                geodesic_distance_field.anchor_points_[portal_edge.ToRef] = portal_point;
+                queue.push(std::make_pair(neighbor_distance, portal_edge.ToRef));
+            }
+        }
+    }
+
+    return geodesic_distance_field;
+}
+
+double NavMesh::getGeodesicDistance(const GeodesicDistanceField& geodesic_distance_field, const FVector& point) const
+{
+    NavNodeRef poly = recast_nav_mesh_->FindNearestPoly(point, recast_nav_mesh_->GetConfig().DefaultQueryExtent);
+    auto distance_itr = geodesic_distance_field.distances_.find(poly);
+    if (poly == INVALID_NAVNODEREF || distance_itr == geodesic_distance_field.distances_.end()) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    return distance_itr->second + FVector::Distance(point, geodesic_distance_field.anchor_points_.at(poly));
+}
+
+int NavMesh::createGeodesicDistanceField(const std::vector<double>& goal_point)
+{
+    SP_ASSERT(goal_point.size() == 3);
+
+    int geodesic_distance_field_id = next_geodesic_distance_field_id_++;
+    Std::insert(geodesic_distance_fields_, geodesic_distance_field_id,
+        computeGeodesicDistanceField(FVector(goal_point.at(0), goal_point.at(1), goal_point.at(2))));
+    return geodesic_distance_field_id;
+}
+
+std::vector<double> NavMesh::getGeodesicDistances(int geodesic_distance_field_id, const std::vector<double>& points) const
+{
+    SP_ASSERT(points.size() % 3 == 0);
+
+    const GeodesicDistanceField& geodesic_distance_field = geodesic_distance_fields_.at(geodesic_distance_field_id);
+    std::vector<double> distances;
+    for (int i = 0; i < points.size(); i += 3) {
+        distances.push_back(getGeodesicDistance(geodesic_distance_field, FVector(points.at(i), points.at(i + 1), points.at(i + 2))));
+    }
+
+    return distances;
+}
+
+void NavMesh::destroyGeodesicDistanceField(int geodesic_distance_field_id)
+{
+    SP_ASSERT(Std::containsKey(geodesic_distance_fields_, geodesic_distance_field_id));
+    geodesic_distance_fields_.erase(geodesic_distance_field_id);
+}
+
+// maximum number of rounds of candidate points that samplePoints(...) draws before giving up on its constraints
+const int MAX_NUM_SAMPLING_ROUNDS = 100;
+
+std::vector<uint8_t> NavMesh::samplePoints(
+    int num_points,
+    int seed,
+    const std::vector<double>& reference_point,
+    bool reachable_from_reference_point,
+    double min_distance_to_reference_point,
+    double max_distance_to_reference_point,
+    double min_separation)
+{
+    SP_ASSERT(num_points >= 0);
+    SP_ASSERT(reference_point.empty() || reference_point.size() == 3);
+    SP_ASSERT(!reachable_from_reference_point || !reference_point.empty());
+    SP_ASSERT(min_distance_to_reference_point <= max_distance_to_reference_point);
+
+    const std::vector<NavMeshTriangle>& triangles = getTriangles();
+
+    FVector reference = reference_point.empty() ? FVector::ZeroVector : FVector(reference_point.at(0), reference_point.at(1), reference_point.at(2));
+
+    // find all polygons reachable from the reference point with a breadth-first search over the polygon graph
+    std::unordered_set<uint64_t> reachable_polys;
+    if (reachable_from_reference_point) {
+        NavNodeRef reference_poly = recast_nav_mesh_->FindNearestPoly(reference, recast_nav_mesh_->GetConfig().DefaultQueryExtent);
+        if (reference_poly != INVALID_NAVNODEREF) {
+            std::queue<uint64_t> frontier;
+            frontier.push(reference_poly);
+            reachable_polys.insert(reference_poly);
+            TArray<FNavigationPortalEdge> portal_edges;
+            while (!frontier.empty()) {
+                uint64_t poly = frontier.front();
+                frontier.pop();
+                portal_edges.Reset();
+                recast_nav_mesh_->GetPolyNeighbors(poly, portal_edges);
+                for (auto& portal_edge : portal_edges) {
+                    if (reachable_polys.insert(portal_edge.ToRef).second) {
+                        frontier.push(portal_edge.ToRef);
+                    }
+                }
+            }
+        }
+    }
+
+    // build the area-weighted CDF over all eligible triangles
+    std::vector<int> triangle_indices;
+    std::vector<double> triangle_cdf;
+    double total_area = 0.0;
+    for (int i = 0; i < triangles.size(); i++) {
+        if (reachable_from_reference_point && !reachable_polys.count(triangles.at(i).poly_)) {
+            continue;
+        }
+        total_area += triangles.at(i).area_;
+        triangle_indices.push_back(i);
+        triangle_cdf.push_back(total_area);
+    }
+
+    std::vector<double> points;
+    if (num_points == 0 || total_area <= 0.0) {
+        return Std::reinterpretAsVectorOf<uint8_t>(points);
+    }
+
+    // accepted points are stored in a hash grid with a cell size of min_separation, so each separation test only
+    // needs to look at the 27 neighboring cells
+    auto get_cell_key = [min_separation](const FVector& point, int dx, int dy, int dz) -> uint64_t {
+        int64_t x = static_cast<int64_t>(std::floor(point.X / min_separation)) + dx;
+        int64_t y = static_cast<int64_t>(std::floor(point.Y / min_separation)) + dy;
+        int64_t z = static_cast<int64_t>(std::floor(point.Z / min_separation)) + dz;
+        return static_cast<uint64_t>(x*73856093) ^ static_cast<uint64_t>(y*19349663) ^ static_cast<uint64_t>(z*83492791);
+    };
+    std::unordered_map<uint64_t, std::vector<FVector>> cells;
+
+    // The output sequence of std::minstd_rand is fully specified by the C++ standard, but the output of the standard
+    // distributions and std::shuffle is implementation-defined, so we map raw outputs to uniform numbers ourselves.
+    // Otherwise, the same seed could produce different points on different platforms.
+    std::minstd_rand minstd_rand(seed);
+    auto uniform_distribution = [&minstd_rand]() -> double {
+        return static_cast<double>(minstd_rand() - std::minstd_rand::min()) / (static_cast<double>(std::minstd_rand::max() - std::minstd_rand::min()) + 1.0);
+    };
+    std::vector<FVector> candidate_points(num_points);
+    int num_points_found = 0;
+
+    for (int round = 0; round < MAX_NUM_SAMPLING_ROUNDS && num_points_found < num_points; round++) {
+
+        // Draw one candidate from each of num_points equal-probability strata of the CDF, so candidates cover the
+        // navigation mesh evenly, then shuffle them so rejection doesn't favor any part of the navigation mesh.
+        for (int i = 0; i < num_points; i++) {
+            double u = (i + uniform_distribution()) / num_points * total_area;
+            int j = std::min(static_cast<int>(std::upper_bound(triangle_cdf.begin(), triangle_cdf.end(), u) - triangle_cdf.begin()), static_cast<int>(triangle_cdf.size()) - 1);
+            const NavMeshTriangle& triangle = triangles.at(triangle_indices.at(j));
+
+            // uniform point in a triangle, see https://www.cs.princeton.edu/~funk/tog02.pdf, Section 4.2
+            double r_1 = std::sqrt(uniform_distribution());
+            double r_2 = uniform_distribution();
+            candidate_points.at(i) = (1.0 - r_1)*triangle.vertex_0_ + r_1*(1.0 - r_2)*triangle.vertex_1_ + r_1*r_2*triangle.vertex_2_;
+        }
+        for (int i = num_points - 1; i > 0; i--) {
+            int j = std::min(static_cast<int>(uniform_distribution()*(i + 1)), i);
+            std::swap(candidate_points.at(i), candidate_points.at(j));
+        }
+
+        for (auto& candidate_point : candidate_points) {
+            if (num_points_found == num_points) {
+                break;
+            }
+
+            if (!reference_point.empty()) {
+                double distance = FVector::Distance(candidate_point, reference);
+                if (distance < min_distance_to_reference_point || distance > max_distance_to_reference_point) {
+                    continue;
+                }
+            }
+
+            if (min_separation > 0.0) {
+                bool separated = true;
+                for (int dx = -1; dx <= 1 && separated; dx++) {
+                    for (int dy = -1; dy <= 1 && separated; dy++) {
+                        for (int dz = -1; dz <= 1 && separated; dz++) {
+                            auto cell_itr = cells.find(get_cell_key(candidate_point, dx, dy, dz));
+                            if (cell_itr == cells.end()) {
+                                continue;
+                            }
+                            for (auto& point : cell_itr->second) {
+                                if (FVector::Distance(candidate_point, point) < min_separation) {
+                                    separated = false;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+                if (!separated) {
+                    continue;
+                }
+                cells[get_cell_key(candidate_point, 0, 0, 0)].push_back(candidate_point);
+            }
+
+            points.push_back(candidate_point.X);
+            points.push_back(candidate_point.Y);
+            points.push_back(candidate_point.Z);
+            num_points_found++;
+        }
+    }
+
+    return Std::reinterpretAsVectorOf<uint8_t>(points);
+}
+
+const std::vector<NavMeshTriangle>& NavMesh::getTriangles()
+{
+    if (!triangles_.empty()) {
+        return triangles_;
+    }
+
+    TArray<FNavPoly> polys;
+    TArray<FVector> vertices;
+    for (int32 tile_index = 0; tile_index < recast_nav_mesh_->GetNavMeshTilesCount(); tile_index++) {
+        polys.Reset();
+        recast_nav_mesh_->GetPolysInTile(tile_index, polys);
+        for (auto& poly : polys) {
+            vertices.Reset();
+            recast_nav_mesh_->GetPolyVerts(poly.Ref, vertices);
+
+            // polygons are convex, so we can triangulate them as a fan around the first vertex
+            for (int i = 1; i + 1 < vertices.Num(); i++) {
+                NavMeshTriangle triangle;
+                triangle.vertex_0_ = vertices[0];
+                triangle.vertex_1_ = vertices[i];
+                triangle.vertex_2_ = vertices[i + 1];
+                triangle.area_ = 0.5*FVector::CrossProduct(vertices[i] - vertices[0], vertices[i + 1] - vertices[0]).Size();
+                triangle.poly_ = poly.Ref;
+                triangles_.push_back(triangle);
+            }
+        }
+    }
+
+    return triangles_;
+}
@@ -4,12 +4,39 @@
 
 #pragma once
 
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <map>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <Math/Vector.h>
+
 class ARecastNavMesh;
 class UNavigationSystemV1;
 class UWorld;
 
+// Geodesic distance from every navigation mesh polygon to a single goal. For each polygon, we store the distance
+// to the goal from an anchor point on the polygon's boundary, and the geodesic distance from a point inside the
+// polygon is approximated as the distance to the anchor point plus the anchor point's distance. Polygons are
+// convex, so this approximation is exact whenever the shortest path leaves the polygon through the anchor point.
+struct GeodesicDistanceField
+{
+    FVector goal_point_ = FVector::ZeroVector;
+    std::unordered_map<uint64_t, double> distances_; // polygon ref -> distance from anchor point to goal in cm
+    std::unordered_map<uint64_t, FVector> anchor_points_;
+};
+
+struct NavMeshTriangle
+{
+    FVector vertex_0_ = FVector::ZeroVector;
+    FVector vertex_1_ = FVector::ZeroVector;
+    FVector vertex_2_ = FVector::ZeroVector;
+    double area_ = 0.0;
+    uint64_t poly_ = 0; // polygon ref that this triangle belongs to
+};
+
 class NavMesh
 {
 public:    
@@ -20,8 +47,63 @@ public:
     std::vector<double> getRandomReachablePointsInRadius(const std::vector<double>& initial_points, const float radius);
     std::vector<std::vector<double>> getPaths(const std::vector<double>& initial_points, const std::vector<double>& goal_points);
 
+    // Finds all paths in parallel, and returns them as packed arrays that can be decoded without per-element overhead:
+    //     "points":   float64 [total_num_points, 3], the points of all paths concatenated together
+    //     "offsets":  int64 [num_paths + 1], path i consists of points offsets[i] to offsets[i+1]
+    //     "statuses": uint8 [num_paths], see PATH_STATUS_* below
+    //     "lengths":  float64 [num_paths], in cm, 0 for paths that failed
+    std::map<std::string, std::vector<uint8_t>> getPathsPacked(const std::vector<double>& initial_points, const std::vector<double>& goal_points);
+
+    // Draws up to num_points points uniformly by area over the navigation mesh, and returns them as a packed float64
+    // array of shape [num_points_found, 3]. Points are stratified over an area-weighted CDF of the navigation mesh's
+    // triangles, and all randomness comes from a generator seeded with seed, so the same seed always produces the same
+    // points for the same navigation mesh, on any instance. If reference_point is non-empty, points can optionally be
+    // restricted to polygons reachable from reference_point, and to a band of Euclidean distances from reference_point.
+    // If min_separation is greater than 0, points are at least min_separation apart. Fewer than num_points points are
+    // returned if the constraints can't be satisfied after MAX_NUM_SAMPLING_ROUNDS rounds of sampling.
+    std::vector<uint8_t> samplePoints(
+        int num_points,
+        int seed,
+        const std::vector<double>& reference_point,
+        bool reachable_from_reference_point,
+        double min_distance_to_reference_point,
+        double max_distance_to_reference_point,
+        double min_separation);
+
+    // Computes a GeodesicDistanceField with a single Dijkstra search over the polygon graph. Points on each portal
+    // are refined to the point closest to the previous anchor point, which approximates the shortest path much
+    // better than using portal midpoints. Area costs are ignored, so distances are pure path lengths in cm.
+    GeodesicDistanceField computeGeodesicDistanceField(const FVector& goal_point) const;
+
+    // Returns infinity if point isn't on the navigation mesh, or can't reach the goal.
+    double getGeodesicDistance(const GeodesicDistanceField& geodesic_distance_field, const FVector& point) const;
+
+    // Used by entry points, which refer to GeodesicDistanceFields by ID so they only need to be computed once.
+    int createGeodesicDistanceField(const std::vector<double>& goal_point);
+    std::vector<double> getGeodesicDistances(int geodesic_distance_field_id, const std::vector<double>& points) const;
+    void destroyGeodesicDistanceField(int geodesic_distance_field_id);
+
+    static constexpr uint8_t PATH_STATUS_SUCCESS = 0;
+    static constexpr uint8_t PATH_STATUS_PARTIAL = 1; // the path ends at the reachable point closest to the goal
+    static constexpr uint8_t PATH_STATUS_FAILURE = 2;
+
 private:
+    // triangulates every polygon in the navigation mesh, the result is cached until the navigation mesh changes
+    const std::vector<NavMeshTriangle>& getTriangles();
+
+    // The navigation mesh cache stores the Detour tiles of a built navigation mesh on disk, so subsequent runs can
+    // load them instead of rebuilding. Cache files are keyed by a hash of the world, the engine version, and every
+    // parameter that affects the build, so a cache file is never loaded for a different configuration.
+    std::string getCacheKey() const;
+    bool loadFromCache(const std::string& cache_file);
+    void saveToCache(const std::string& cache_file) const;
+
     UWorld* world_ = nullptr;
     UNavigationSystemV1* navigation_system_v1_ = nullptr;
     ARecastNavMesh* recast_nav_mesh_ = nullptr;
+    bool navigation_auto_update_disabled_ = false; // true if we disabled auto-update after loading from the cache
+
+    std::vector<NavMeshTriangle> triangles_;
+    std::map<int, GeodesicDistanceField> geodesic_distance_fields_;
+    int next_geodesic_distance_field_id_ = 0;
 };
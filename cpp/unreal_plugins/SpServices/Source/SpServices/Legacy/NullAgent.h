@@ -20,7 +20,7 @@ class NullAgent: public Agent
 {
 public:
     NullAgent() = default;
-    NullAgent(UWorld*) {}
+    NullAgent(UWorld*, int) {}
     ~NullAgent() = default;
 
     void findObjectReferences(UWorld* world) override {};
@@ -52,6 +52,8 @@ public:
     {
         return {};
     };
+
+    void requestSensorUpdates(const std::vector<std::string>& sensor_names) override {};
     
     void reset() override {};
 
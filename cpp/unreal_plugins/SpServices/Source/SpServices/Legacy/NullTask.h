@@ -54,4 +54,11 @@ public:
     {
         return true;
     }
+
+    std::vector<uint8_t> getResetState() const override
+    {
+        return {};
+    }
+
+    void setResetState(const std::vector<uint8_t>& reset_state) override {}
 };
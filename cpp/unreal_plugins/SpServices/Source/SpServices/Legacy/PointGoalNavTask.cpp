@@ -4,13 +4,14 @@
 
 #include "SpServices/Legacy/PointGoalNavTask.h"
 
-#include <stdint.h> // uint8_t
+#include <stdint.h> // uint8_t, uint64_t
 
 #include <map>
 #include <memory>  // std::make_unique
-#include <random>  // std::minstd_rand
+#include <random>  // std::minstd_rand, std::uniform_int_distribution, std::uniform_real_distribution
+#include <sstream> // std::istringstream, std::ostringstream
 #include <string>
-#include <utility> // std::move
+#include <utility> // std::move, std::pair
 #include <vector>
 
 #include <Engine/StaticMesh.h>
@@ -28,13 +29,17 @@
 #include "SpCore/Unreal.h"
 
 #include "SpServices/Legacy/ActorHitComponent.h"
+#include "SpServices/Legacy/AgentInstance.h"
+#include "SpServices/Legacy/EpisodeBank.h"
 #include "SpServices/Legacy/StandaloneComponent.h"
 
-PointGoalNavTask::PointGoalNavTask(UWorld* world)
+PointGoalNavTask::PointGoalNavTask(UWorld* world, int agent_index)
 {
+    agent_index_ = agent_index;
+
     // Spawn actor
     FActorSpawnParameters actor_spawn_parameters;
-    actor_spawn_parameters.Name = Unreal::toFName(Config::get<std::string>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.GOAL_ACTOR_NAME"));
+    actor_spawn_parameters.Name = Unreal::toFName(AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.GOAL_ACTOR_NAME"), agent_index_));
     actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
     goal_actor_ = world->SpawnActor<AStaticMeshActor>(FVector::ZeroVector, FRotator::ZeroRotator, actor_spawn_parameters);
     SP_ASSERT(goal_actor_);
@@ -64,13 +69,22 @@ PointGoalNavTask::PointGoalNavTask(UWorld* world)
     SP_ASSERT(actor_hit_component_);
     SP_ASSERT(actor_hit_component_->component_);
 
-    minstd_rand_ = std::minstd_rand(Config::get<int>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.RANDOM_SEED"));
+    // if an episode bank is set, episodes are drawn from the bank instead of the EPISODE_BEGIN ranges
+    if (Config::get<std::string>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BANK_FILE") != "") {
+        episode_bank_ = std::make_unique<EpisodeBank>(Config::get<std::string>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BANK_FILE"));
+        SP_ASSERT(episode_bank_);
+    }
+
+    // offset the seed by the agent index, so vectorized agents draw different episodes
+    minstd_rand_ = std::minstd_rand(Config::get<int>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.RANDOM_SEED") + agent_index_);
     hit_goal_ = false;
     hit_obstacle_ = false;
 }
 
 PointGoalNavTask::~PointGoalNavTask()
 {
+    episode_bank_ = nullptr;
+
     SP_ASSERT(actor_hit_component_);
     actor_hit_component_ = nullptr;
 
@@ -81,7 +95,7 @@ PointGoalNavTask::~PointGoalNavTask()
 
 void PointGoalNavTask::findObjectReferences(UWorld* world)
 {
-    agent_actor_ = Unreal::findActorByName(world, Config::get<std::string>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.AGENT_ACTOR_NAME"));
+    agent_actor_ = Unreal::findActorByName(world, AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.AGENT_ACTOR_NAME"), agent_index_));
     SP_ASSERT(agent_actor_);
 
     bool return_null_if_not_found = false;
@@ -183,34 +197,63 @@ std::map<std::string, std::vector<uint8_t>> PointGoalNavTask::getStepInfo() cons
 
 void PointGoalNavTask::reset()
 {
+    if (episode_bank_) {
+        resetFromEpisodeBank();
+        return;
+    }
+
+    // read config values once, rather than once per rejected sample
+    double spawn_distance_threshold = Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.SPAWN_DISTANCE_THRESHOLD");
+    double agent_position_z = Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_Z");
+    double goal_position_z = Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_Z");
+    std::uniform_real_distribution distribution_agent_position_x(
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_X_MIN"),
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_X_MAX"));
+    std::uniform_real_distribution distribution_agent_position_y(
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_Y_MIN"),
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_Y_MAX"));
+    std::uniform_real_distribution distribution_goal_position_x(
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_X_MIN"),
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_X_MAX"));
+    std::uniform_real_distribution distribution_goal_position_y(
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_Y_MIN"),
+        Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_Y_MAX"));
+
     FVector agent_position;
     FVector goal_position;
 
-    while ((agent_position - goal_position).Size() < Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.SPAWN_DISTANCE_THRESHOLD")) {
-
-        std::uniform_real_distribution distribution_agent_position_x(
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_X_MIN"),
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_X_MAX"));
-        std::uniform_real_distribution distribution_agent_position_y(
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_Y_MIN"),
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_Y_MAX"));
-        std::uniform_real_distribution distribution_goal_position_x(
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_X_MIN"),
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_X_MAX"));
-        std::uniform_real_distribution distribution_goal_position_y(
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_Y_MIN"),
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_Y_MAX"));
-
-        agent_position = FVector(
-            distribution_agent_position_x(minstd_rand_),
-            distribution_agent_position_y(minstd_rand_),
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.AGENT_LOCATION_Z"));
-        goal_position = FVector(
-            distribution_goal_position_x(minstd_rand_),
-            distribution_goal_position_y(minstd_rand_),
-            Config::get<double>("SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BEGIN.GOAL_LOCATION_Z"));
+    while ((agent_position - goal_position).Size() < spawn_distance_threshold) {
+        agent_position = FVector(distribution_agent_position_x(minstd_rand_), distribution_agent_position_y(minstd_rand_), agent_position_z);
+        goal_position = FVector(distribution_goal_position_x(minstd_rand_), distribution_goal_position_y(minstd_rand_), goal_position_z);
     }
 
+    agent_position += AgentInstance::getOffset(agent_index_);
+    goal_position += AgentInstance::getOffset(agent_index_);
+
+    bool sweep = false;
+    FHitResult* hit_result = nullptr;
+    agent_actor_->SetActorLocationAndRotation(agent_position, FRotator::ZeroRotator, sweep, hit_result, ETeleportType::TeleportPhysics);
+    goal_actor_->SetActorLocationAndRotation(goal_position, FRotator::ZeroRotator, sweep, hit_result, ETeleportType::TeleportPhysics);
+}
+
+void PointGoalNavTask::resetFromEpisodeBank()
+{
+    SP_ASSERT(episode_bank_);
+
+    UWorld* world = agent_actor_->GetWorld();
+    SP_ASSERT(world);
+
+    std::pair<uint64_t, uint64_t> episode_range = episode_bank_->getEpisodeRange(Unreal::toStdString(world->GetName()));
+    SP_ASSERT(episode_range.second > 0);
+
+    std::uniform_int_distribution<uint64_t> distribution_episode_index(episode_range.first, episode_range.first + episode_range.second - 1);
+    const EpisodeBankEpisode& episode = episode_bank_->getEpisode(distribution_episode_index(minstd_rand_));
+    FVector agent_position = {episode.initial_location_[0], episode.initial_location_[1], episode.initial_location_[2]};
+    FVector goal_position = {episode.goal_location_[0], episode.goal_location_[1], episode.goal_location_[2]};
+
+    agent_position += AgentInstance::getOffset(agent_index_);
+    goal_position += AgentInstance::getOffset(agent_index_);
+
     bool sweep = false;
     FHitResult* hit_result = nullptr;
     agent_actor_->SetActorLocationAndRotation(agent_position, FRotator::ZeroRotator, sweep, hit_result, ETeleportType::TeleportPhysics);
@@ -221,3 +264,19 @@ bool PointGoalNavTask::isReady() const
 {
     return true;
 }
+
+std::vector<uint8_t> PointGoalNavTask::getResetState() const
+{
+    // std::minstd_rand only supports serializing its state as text
+    std::ostringstream ss;
+    ss << minstd_rand_;
+    std::string reset_state = ss.str();
+    return std::vector<uint8_t>(reset_state.begin(), reset_state.end());
+}
+
+void PointGoalNavTask::setResetState(const std::vector<uint8_t>& reset_state)
+{
+    std::istringstream ss(std::string(reset_state.begin(), reset_state.end()));
+    ss >> minstd_rand_;
+    SP_ASSERT(!ss.fail());
+}
@@ -17,6 +17,7 @@
 #include "SpCore/ArrayDesc.h" // TODO: remove
 
 #include "SpServices/Legacy/ActorHitComponent.h"
+#include "SpServices/Legacy/EpisodeBank.h"
 #include "SpServices/Legacy/StandaloneComponent.h"
 #include "SpServices/Legacy/Task.h"
 
@@ -27,7 +28,7 @@ class UWorld;
 class PointGoalNavTask: public Task
 {
 public:
-    PointGoalNavTask(UWorld* world);
+    PointGoalNavTask(UWorld* world, int agent_index);
     ~PointGoalNavTask();
 
     void findObjectReferences(UWorld* world) override;
@@ -42,14 +43,23 @@ public:
     std::map<std::string, std::vector<uint8_t>> getStepInfo() const override;
     void reset() override;
     bool isReady() const override;
+    std::vector<uint8_t> getResetState() const override;
+    void setResetState(const std::vector<uint8_t>& reset_state) override;
 
 private:
+    int agent_index_ = 0;
+
+    void resetFromEpisodeBank();
+
     AStaticMeshActor* goal_actor_ = nullptr;
     AActor* agent_actor_ = nullptr;
     std::vector<AActor*> obstacle_ignore_actors_;
 
     std::unique_ptr<StandaloneComponent<UActorHitComponent>> actor_hit_component_ = nullptr;
 
+    // only used if SP_SERVICES.LEGACY.POINT_GOAL_NAV_TASK.EPISODE_BANK_FILE is set
+    std::unique_ptr<EpisodeBank> episode_bank_ = nullptr;
+
     std::minstd_rand minstd_rand_;
     bool hit_goal_ = false;
     bool hit_obstacle_ = false;
@@ -0,0 +1,121 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/RenderPassCompaction.h"
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, uint64_t
+
+#include <cmath>    // std::abs
+#include <string>
+
+#include <HAL/PlatformMath.h>     // FPlatformMath::StoreHalf, FPlatformMath::VectorStoreHalf
+#include <Math/VectorRegister.h>  // VectorLoad, VectorShuffle, VectorStore
+
+#include "SpCore/Assert.h"
+
+void RenderPassCompaction::compact(const std::string& format, const void* src, void* dest, uint64_t num_pixels)
+{
+    SP_ASSERT(src);
+    SP_ASSERT(dest);
+
+    if (format == "r32f") {
+        compactRGBA32FToR32F(static_cast<const float*>(src), static_cast<float*>(dest), num_pixels);
+    } else if (format == "r16f") {
+        compactRGBA32FToR16F(static_cast<const float*>(src), static_cast<uint16_t*>(dest), num_pixels);
+    } else if (format == "rgb16f") {
+        compactRGBA32FToRGB16F(static_cast<const float*>(src), static_cast<uint16_t*>(dest), num_pixels);
+    } else if (format == "rg16f_octahedral") {
+        compactRGBA32FToRG16FOctahedral(static_cast<const float*>(src), static_cast<uint16_t*>(dest), num_pixels);
+    } else if (format == "r16ui") {
+        compactBGRA8ToR16UI(static_cast<const uint8_t*>(src), static_cast<uint16_t*>(dest), num_pixels);
+    } else if (format == "r32ui") {
+        compactBGRA8ToR32UI(static_cast<const uint8_t*>(src), static_cast<uint32_t*>(dest), num_pixels);
+    } else {
+        SP_ASSERT(false);
+    }
+}
+
+void RenderPassCompaction::compactRGBA32FToR32F(const float* src, float* dest, uint64_t num_pixels)
+{
+    // Gather the first channel of 4 pixels into a single register, and then store all 4 values at once.
+    uint64_t i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        VectorRegister4Float pixel_0 = VectorLoad(src + 4*i);
+        VectorRegister4Float pixel_1 = VectorLoad(src + 4*i + 4);
+        VectorRegister4Float pixel_2 = VectorLoad(src + 4*i + 8);
+        VectorRegister4Float pixel_3 = VectorLoad(src + 4*i + 12);
+        VectorRegister4Float pixels_01 = VectorShuffle(pixel_0, pixel_1, 0, 0, 0, 0); // (r0, r0, r1, r1)
+        VectorRegister4Float pixels_23 = VectorShuffle(pixel_2, pixel_3, 0, 0, 0, 0); // (r2, r2, r3, r3)
+        VectorStore(VectorShuffle(pixels_01, pixels_23, 0, 2, 0, 2), dest + i);   // (r0, r1, r2, r3)
+    }
+    for (; i < num_pixels; i++) {
+        dest[i] = src[4*i];
+    }
+}
+
+void RenderPassCompaction::compactRGBA32FToR16F(const float* src, uint16_t* dest, uint64_t num_pixels)
+{
+    uint64_t i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        float values[4] = {src[4*i], src[4*i + 4], src[4*i + 8], src[4*i + 12]};
+        FPlatformMath::VectorStoreHalf(dest + i, values);
+    }
+    for (; i < num_pixels; i++) {
+        FPlatformMath::StoreHalf(dest + i, src[4*i]);
+    }
+}
+
+void RenderPassCompaction::compactRGBA32FToRGB16F(const float* src, uint16_t* dest, uint64_t num_pixels)
+{
+    // VectorStoreHalf(...) always writes 4 values, so we write all 4 channels of each pixel into a temporary
+    // buffer and copy the first 3.
+    for (uint64_t i = 0; i < num_pixels; i++) {
+        uint16_t values[4];
+        FPlatformMath::VectorStoreHalf(values, src + 4*i);
+        dest[3*i]     = values[0];
+        dest[3*i + 1] = values[1];
+        dest[3*i + 2] = values[2];
+    }
+}
+
+void RenderPassCompaction::compactRGBA32FToRG16FOctahedral(const float* src, uint16_t* dest, uint64_t num_pixels)
+{
+    for (uint64_t i = 0; i < num_pixels; i++) {
+        float x = src[4*i];
+        float y = src[4*i + 1];
+        float z = src[4*i + 2];
+
+        // project onto the octahedron, and fold the lower hemisphere over the upper hemisphere
+        float l1_norm = std::abs(x) + std::abs(y) + std::abs(z);
+        float u = 0.0f;
+        float v = 0.0f;
+        if (l1_norm > 0.0f) {
+            u = x / l1_norm;
+            v = y / l1_norm;
+            if (z < 0.0f) {
+                float u_folded = (1.0f - std::abs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+                float v_folded = (1.0f - std::abs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+                u = u_folded;
+                v = v_folded;
+            }
+        }
+
+        FPlatformMath::StoreHalf(dest + 2*i, u);
+        FPlatformMath::StoreHalf(dest + 2*i + 1, v);
+    }
+}
+
+void RenderPassCompaction::compactBGRA8ToR16UI(const uint8_t* src, uint16_t* dest, uint64_t num_pixels)
+{
+    for (uint64_t i = 0; i < num_pixels; i++) {
+        dest[i] = static_cast<uint16_t>(src[4*i + 2]) | static_cast<uint16_t>(src[4*i + 1]) << 8;
+    }
+}
+
+void RenderPassCompaction::compactBGRA8ToR32UI(const uint8_t* src, uint32_t* dest, uint64_t num_pixels)
+{
+    for (uint64_t i = 0; i < num_pixels; i++) {
+        dest[i] = static_cast<uint32_t>(src[4*i + 2]) | static_cast<uint32_t>(src[4*i + 1]) << 8 | static_cast<uint32_t>(src[4*i]) << 16;
+    }
+}
@@ -0,0 +1,35 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, uint64_t
+
+#include <string>
+
+// Unreal's ReadPixels functions always return 4 channels per pixel, but most render passes only need one or
+// two channels. These functions convert a 4-channel image into a more compact format on the CPU before the
+// image is written to shared memory or serialized. The src and dest buffers must not overlap.
+class RenderPassCompaction
+{
+public:
+    RenderPassCompaction() = delete;
+    ~RenderPassCompaction() = delete;
+
+    // dispatches to one of the functions below based on the name of the output format
+    static void compact(const std::string& format, const void* src, void* dest, uint64_t num_pixels);
+
+    // depth
+    static void compactRGBA32FToR32F(const float* src, float* dest, uint64_t num_pixels);
+    static void compactRGBA32FToR16F(const float* src, uint16_t* dest, uint64_t num_pixels);
+
+    // normal
+    static void compactRGBA32FToRGB16F(const float* src, uint16_t* dest, uint64_t num_pixels);
+    static void compactRGBA32FToRG16FOctahedral(const float* src, uint16_t* dest, uint64_t num_pixels); // see https://jcgt.org/published/0003/02/01
+
+    // segmentation, src is in the BGRA order returned by ReadPixels, and ids are computed as R | G << 8 | B << 16,
+    // truncated to the size of the output type
+    static void compactBGRA8ToR16UI(const uint8_t* src, uint16_t* dest, uint64_t num_pixels);
+    static void compactBGRA8ToR32UI(const uint8_t* src, uint32_t* dest, uint64_t num_pixels);
+};
@@ -0,0 +1,55 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/SensorSchedule.h"
+
+#include "SpCore/Assert.h"
+
+// Simulated time advances in floating-point increments, so we allow updates slightly before they are due. Otherwise,
+// a 10 Hz sensor in a 100 Hz simulation could skip an update because 10 increments of 0.01 add up to 0.0999...
+const double UPDATE_TIME_TOLERANCE = 1e-6;
+
+SensorSchedule::SensorSchedule(double update_rate, bool update_on_demand)
+{
+    SP_ASSERT(update_rate >= 0.0);
+    update_period_ = (update_rate > 0.0) ? 1.0 / update_rate : 0.0;
+    update_on_demand_ = update_on_demand;
+}
+
+bool SensorSchedule::shouldUpdate(double time)
+{
+    bool should_update = false;
+
+    if (update_on_demand_) {
+        should_update = update_requested_;
+        update_requested_ = false;
+    } else if (update_period_ == 0.0) {
+        should_update = true;
+    } else if (time >= next_update_time_ - UPDATE_TIME_TOLERANCE) {
+        should_update = true;
+
+        // advance by a whole number of periods, so the schedule doesn't drift if a frame is late, and doesn't try to
+        // catch up if several periods were skipped
+        next_update_time_ += update_period_;
+        if (next_update_time_ <= time) {
+            next_update_time_ = time + update_period_;
+        }
+    }
+
+    if (should_update) {
+        update_time_ = time;
+    }
+
+    return should_update;
+}
+
+void SensorSchedule::requestUpdate()
+{
+    update_requested_ = true;
+}
+
+bool SensorSchedule::isThrottled() const
+{
+    return update_on_demand_ || update_period_ > 0.0;
+}
@@ -0,0 +1,34 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+// A SensorSchedule decides on which frames a sensor should update. If update_on_demand is true, the sensor only
+// updates on the first frame after requestUpdate() is called, and update_rate is ignored. Otherwise, if update_rate
+// is greater than 0, the sensor updates at most update_rate times per second of simulated time, and if update_rate
+// is 0, the sensor updates every frame. The time of the most recent update is stored in update_time_, so it can be
+// returned alongside the sensor's observations.
+class SensorSchedule
+{
+public:
+    SensorSchedule() = delete;
+    SensorSchedule(double update_rate, bool update_on_demand);
+
+    // Called once per frame by the sensor. Returns true if the sensor should update on this frame.
+    bool shouldUpdate(double time);
+
+    void requestUpdate();
+
+    // Returns true if the sensor doesn't update every frame, in which case it might need to disable work that Unreal
+    // would otherwise do every frame on its behalf.
+    bool isThrottled() const;
+
+    double update_time_ = -1.0; // -1 until the first update
+
+private:
+    double update_period_ = 0.0;
+    bool update_on_demand_ = false;
+    bool update_requested_ = false;
+    double next_update_time_ = 0.0;
+};
@@ -31,14 +31,17 @@
 #include "SpCore/Std.h"
 #include "SpCore/Unreal.h"
 
+#include "SpServices/Legacy/AgentInstance.h"
 #include "SpServices/Legacy/CameraSensor.h"
 #include "SpServices/Legacy/StandaloneComponent.h"
 #include "SpServices/Legacy/TickComponent.h"
 
 struct FActorComponentTickFunction;
 
-SphereAgent::SphereAgent(UWorld* world)
+SphereAgent::SphereAgent(UWorld* world, int agent_index)
 {
+    agent_index_ = agent_index;
+
     // Spawn static mesh actor
     FVector spawn_location = FVector::ZeroVector;
     FRotator spawn_rotation = FRotator::ZeroRotator;
@@ -60,8 +63,10 @@ SphereAgent::SphereAgent(UWorld* world)
     } else {
         SP_ASSERT(false);
     }
+    spawn_location += AgentInstance::getOffset(agent_index_);
+
     FActorSpawnParameters static_mesh_actor_spawn_parameters;
-    static_mesh_actor_spawn_parameters.Name = Unreal::toFName(Config::get<std::string>("SP_SERVICES.LEGACY.SPHERE_AGENT.SPHERE_ACTOR_NAME"));
+    static_mesh_actor_spawn_parameters.Name = Unreal::toFName(AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.SPHERE_AGENT.SPHERE_ACTOR_NAME"), agent_index_));
     static_mesh_actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
     static_mesh_actor_ = world->SpawnActor<AStaticMeshActor>(spawn_location, spawn_rotation, static_mesh_actor_spawn_parameters);
     SP_ASSERT(static_mesh_actor_);
@@ -94,7 +99,7 @@ SphereAgent::SphereAgent(UWorld* world)
 
     // Spawn camera actor
     FActorSpawnParameters camera_actor_spawn_parameters;
-    camera_actor_spawn_parameters.Name = Unreal::toFName(Config::get<std::string>("SP_SERVICES.LEGACY.SPHERE_AGENT.CAMERA_ACTOR_NAME"));
+    camera_actor_spawn_parameters.Name = Unreal::toFName(AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.SPHERE_AGENT.CAMERA_ACTOR_NAME"), agent_index_));
     camera_actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
     camera_actor_ = world->SpawnActor<ACameraActor>(FVector::ZeroVector, FRotator::ZeroRotator, camera_actor_spawn_parameters);
     SP_ASSERT(camera_actor_);
@@ -248,7 +253,7 @@ std::map<std::string, std::vector<uint8_t>> SphereAgent::getObservation() const
     auto observation_components = Config::get<std::vector<std::string>>("SP_SERVICES.LEGACY.SPHERE_AGENT.OBSERVATION_COMPONENTS");
 
     if (Std::contains(observation_components, "location")) {
-        FVector location = static_mesh_actor_->GetActorLocation();
+        FVector location = static_mesh_actor_->GetActorLocation() - AgentInstance::getOffset(agent_index_);
         Std::insert(observation, "location", Std::reinterpretAsVector<uint8_t, double>({location.X, location.Y, location.Z}));
     }
 
@@ -275,6 +280,15 @@ std::map<std::string, std::vector<uint8_t>> SphereAgent::getStepInfo() const
     return step_info;
 }
 
+void SphereAgent::requestSensorUpdates(const std::vector<std::string>& sensor_names)
+{
+    auto observation_components = Config::get<std::vector<std::string>>("SP_SERVICES.LEGACY.SPHERE_AGENT.OBSERVATION_COMPONENTS");
+
+    if (Std::contains(observation_components, "camera") && Std::contains(sensor_names, "camera")) {
+        camera_sensor_->requestUpdate();
+    }
+}
+
 void SphereAgent::reset()
 {
     static_mesh_component_->SetPhysicsLinearVelocity(FVector::ZeroVector);
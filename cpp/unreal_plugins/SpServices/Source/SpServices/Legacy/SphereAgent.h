@@ -31,7 +31,7 @@ class SphereAgent : public Agent
 {
 public:
     SphereAgent() = delete;
-    SphereAgent(UWorld* world);
+    SphereAgent(UWorld* world, int agent_index);
     ~SphereAgent();
  
     void findObjectReferences(UWorld* world) override;
@@ -44,11 +44,14 @@ public:
     void applyAction(const std::map<std::string, std::vector<uint8_t>>& action) override;
     std::map<std::string, std::vector<uint8_t>> getObservation() const override;
     std::map<std::string, std::vector<uint8_t>> getStepInfo() const override;
+    void requestSensorUpdates(const std::vector<std::string>& sensor_names) override;
 
     void reset() override;
     bool isReady() const override;
 
 private:
+    int agent_index_ = 0;
+
     AStaticMeshActor* static_mesh_actor_ = nullptr;
     ACameraActor* camera_actor_ = nullptr;
 
@@ -34,4 +34,10 @@ public:
     virtual std::map<std::string, std::vector<uint8_t>> getStepInfo() const = 0;
     virtual void reset() = 0;
     virtual bool isReady() const = 0;
+
+    // The reset state is whatever determines the episode that the next call to reset() will produce (e.g., the state
+    // of a random number generator). LegacyService records it when it starts recording an action log, and restores it
+    // before replaying one, so the replayed episodes match the recorded ones.
+    virtual std::vector<uint8_t> getResetState() const = 0;
+    virtual void setResetState(const std::vector<uint8_t>& reset_state) = 0;
 };
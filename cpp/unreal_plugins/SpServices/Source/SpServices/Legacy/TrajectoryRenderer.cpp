@@ -0,0 +1,260 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/Legacy/TrajectoryRenderer.h"
+
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <chrono>  // std::chrono::duration, std::chrono::steady_clock
+#include <map>
+#include <memory>  // std::make_unique
+#include <string>
+#include <thread>  // std::this_thread::yield
+#include <utility> // std::move
+#include <vector>
+
+#include <Camera/CameraActor.h>
+#include <Camera/CameraComponent.h>
+#include <Components/SceneCaptureComponent2D.h>
+#include <Engine/World.h>  // FActorSpawnParameters
+#include <Math/Quat.h>
+#include <Math/Rotator.h>
+#include <Math/Vector.h>
+
+#include "SpCore/ArrayDesc.h" // TODO: remove
+#include "SpCore/Assert.h"
+#include "SpCore/Boost.h"
+#include "SpCore/SharedMemoryFrameRing.h"
+#include "SpCore/SharedMemoryRegion.h"
+#include "SpCore/Std.h"
+
+#include "SpServices/Legacy/CameraReadbackQueue.h"
+#include "SpServices/Legacy/CameraSensor.h"
+#include "SpServices/Legacy/DatasetWriter.h"
+#include "SpServices/Legacy/RenderPassCompaction.h"
+
+// each slot begins with the index of the pose within the trajectory, padded to SharedMemoryFrameRing::ALIGNMENT
+const uint64_t SLOT_HEADER_NUM_BYTES = 64;
+
+TrajectoryRenderer::TrajectoryRenderer(
+    UWorld* world, const std::vector<std::string>& render_pass_names, unsigned int width, unsigned int height, float fov, int num_slots)
+{
+    SP_ASSERT(world);
+    SP_ASSERT(num_slots > 0);
+    num_slots_ = num_slots;
+
+    FActorSpawnParameters actor_spawn_parameters;
+    actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    camera_actor_ = world->SpawnActor<ACameraActor>(FVector::ZeroVector, FRotator::ZeroRotator, actor_spawn_parameters);
+    SP_ASSERT(camera_actor_);
+    camera_actor_->GetCameraComponent()->FieldOfView = fov;
+    camera_actor_->GetCameraComponent()->AspectRatio = static_cast<float>(width) / height;
+
+    // TrajectoryRenderer reads render passes directly with readRenderPass(...), so derived outputs would never be computed
+    camera_sensor_ = std::make_unique<CameraSensor>(
+        camera_actor_->GetCameraComponent(), render_pass_names, width, height, fov, "trajectory", false);
+    SP_ASSERT(camera_sensor_);
+
+    // we capture explicitly in renderTrajectory(...), and we persist rendering state across captures so warm-up
+    // captures contribute to the temporal history of the final capture
+    camera_sensor_->setTickEnabled(false);
+    for (auto& [render_pass_name, render_pass_desc] : camera_sensor_->render_pass_descs_) {
+        render_pass_desc.scene_capture_component_2d_->bAlwaysPersistRenderingState = true;
+    }
+
+    // each pose has at most one copy in flight while the next pose is being captured, so a latency of 1 is enough
+    for (auto& [render_pass_name, render_pass_desc] : camera_sensor_->render_pass_descs_) {
+        uint64_t num_pixels = static_cast<uint64_t>(render_pass_desc.width_) * render_pass_desc.height_;
+        std::unique_ptr<CameraReadbackQueue> readback_queue = std::make_unique<CameraReadbackQueue>(
+            1, render_pass_desc.width_, render_pass_desc.height_, static_cast<int>(render_pass_desc.readback_num_bytes_ / num_pixels));
+        SP_ASSERT(readback_queue);
+        Std::insert(readback_queues_, render_pass_name, std::move(readback_queue));
+    }
+
+    // std::map iterates in sorted order, which defines the layout of each slot
+    slot_num_bytes_ = SLOT_HEADER_NUM_BYTES;
+    for (auto& [render_pass_name, render_pass_desc] : camera_sensor_->render_pass_descs_) {
+        Std::insert(render_pass_offsets_, render_pass_name, slot_num_bytes_);
+        slot_num_bytes_ += (render_pass_desc.num_bytes_ + SharedMemoryFrameRing::ALIGNMENT - 1) & ~(SharedMemoryFrameRing::ALIGNMENT - 1);
+    }
+
+    uint64_t shared_memory_num_bytes = SharedMemoryFrameRing::getNumBytes(num_slots_, slot_num_bytes_);
+    shared_memory_id_ = SharedMemoryRegion::getUniqueIdString(SharedMemoryRegion::getUniqueId());
+
+    #if BOOST_OS_WINDOWS
+        shared_memory_name_ = shared_memory_id_; // ID doesn't have a leading slash on Windows
+        boost::interprocess::windows_shared_memory windows_shared_memory(
+            boost::interprocess::create_only,
+            shared_memory_id_.c_str(),
+            boost::interprocess::read_write,
+            shared_memory_num_bytes);
+        shared_memory_mapped_region_ = boost::interprocess::mapped_region(windows_shared_memory, boost::interprocess::read_write);
+    #elif BOOST_OS_MACOS || BOOST_OS_LINUX
+        shared_memory_name_ = shared_memory_id_.substr(1); // ID has a leading slash on macOS and Linux, but the externally visible name doesn't
+        boost::interprocess::shared_memory_object::remove(shared_memory_id_.c_str());
+        boost::interprocess::shared_memory_object shared_memory_object(
+            boost::interprocess::create_only,
+            shared_memory_id_.c_str(),
+            boost::interprocess::read_write);
+        shared_memory_object.truncate(shared_memory_num_bytes);
+        shared_memory_mapped_region_ = boost::interprocess::mapped_region(shared_memory_object, boost::interprocess::read_write);
+    #else
+        #error
+    #endif
+
+    SharedMemoryRegion::applyFlags(shared_memory_mapped_region_, SharedMemoryRegion::getGlobalFlags());
+
+    SharedMemoryFrameRing::initialize(shared_memory_mapped_region_.get_address(), num_slots_, slot_num_bytes_);
+}
+
+TrajectoryRenderer::~TrajectoryRenderer()
+{
+    #if BOOST_OS_MACOS || BOOST_OS_LINUX
+        boost::interprocess::shared_memory_object::remove(shared_memory_id_.c_str());
+    #endif
+
+    // the DatasetWriter and readback queues read from our CameraSensor, so they must be destroyed first
+    dataset_writer_ = nullptr;
+    readback_queues_.clear();
+
+    SP_ASSERT(camera_sensor_);
+    camera_sensor_ = nullptr;
+
+    SP_ASSERT(camera_actor_);
+    camera_actor_->Destroy();
+    camera_actor_ = nullptr;
+}
+
+std::map<std::string, ArrayDesc> TrajectoryRenderer::getFrameSpace() const
+{
+    std::map<std::string, ArrayDesc> frame_space;
+    std::map<std::string, ArrayDesc> observation_space = camera_sensor_->getObservationSpace();
+
+    for (auto& [render_pass_name, render_pass_offset] : render_pass_offsets_) {
+        ArrayDesc array_desc = observation_space.at("trajectory." + render_pass_name);
+        array_desc.use_shared_memory_ = true;
+        array_desc.shared_memory_name_ = shared_memory_name_;
+        array_desc.shared_memory_num_slots_ = num_slots_;
+        Std::insert(frame_space, "trajectory." + render_pass_name, std::move(array_desc));
+    }
+
+    return frame_space;
+}
+
+int TrajectoryRenderer::renderTrajectory(const std::vector<double>& poses, int num_pose_components, int num_warmup_frames, double timeout)
+{
+    SP_ASSERT(num_pose_components == 6 || num_pose_components == 7);
+    SP_ASSERT(poses.size() % num_pose_components == 0);
+    SP_ASSERT(num_warmup_frames >= 0);
+
+    int num_poses = static_cast<int>(poses.size() / num_pose_components);
+    int num_frames_published = 0;
+    int pending_pose_index = -1;
+
+    for (int i = 0; i < num_poses; i++) {
+        const double* pose = poses.data() + i*num_pose_components;
+        FVector location(pose[0], pose[1], pose[2]);
+        if (num_pose_components == 6) {
+            camera_actor_->SetActorLocationAndRotation(location, FRotator(pose[3], pose[4], pose[5]));
+        } else {
+            camera_actor_->SetActorLocationAndRotation(location, FQuat(pose[3], pose[4], pose[5], pose[6]));
+        }
+
+        for (int j = 0; j < num_warmup_frames + 1; j++) {
+            for (auto& [render_pass_name, render_pass_desc] : camera_sensor_->render_pass_descs_) {
+                render_pass_desc.scene_capture_component_2d_->CaptureScene();
+            }
+        }
+
+        // the copies are enqueued on the render thread after the captures above, so they contain the final capture
+        // of this pose even though the next pose's captures overwrite the render targets
+        for (auto& [render_pass_name, render_pass_desc] : camera_sensor_->render_pass_descs_) {
+            readback_queues_.at(render_pass_name)->enqueueCopy(render_pass_desc.scene_capture_component_2d_->TextureTarget);
+        }
+
+        // publish the previous pose while the GPU is rendering this one
+        if (pending_pose_index != -1) {
+            if (!publishFrame(pending_pose_index, timeout)) {
+                pending_pose_index = -1;
+                break;
+            }
+            num_frames_published++;
+        }
+        pending_pose_index = i;
+    }
+
+    if (pending_pose_index != -1 && publishFrame(pending_pose_index, timeout)) {
+        num_frames_published++;
+    }
+
+    // if we timed out, the most recent copies were never read back
+    for (auto& [render_pass_name, readback_queue] : readback_queues_) {
+        readback_queue->discardPendingCopies();
+    }
+
+    return num_frames_published;
+}
+
+void TrajectoryRenderer::createDatasetWriter(const std::string& directory, const std::map<std::string, std::string>& encodings)
+{
+    SP_ASSERT(!dataset_writer_);
+    dataset_writer_ = std::make_unique<DatasetWriter>(camera_sensor_.get(), directory, encodings);
+    SP_ASSERT(dataset_writer_);
+}
+
+void TrajectoryRenderer::destroyDatasetWriter()
+{
+    SP_ASSERT(dataset_writer_);
+    dataset_writer_ = nullptr;
+}
+
+bool TrajectoryRenderer::publishFrame(int pose_index, double timeout)
+{
+    if (dataset_writer_) {
+        std::map<std::string, std::vector<uint8_t>> render_pass_data;
+        for (auto& [render_pass_name, render_pass_desc] : camera_sensor_->render_pass_descs_) {
+            std::vector<uint8_t> data(render_pass_desc.num_bytes_);
+            readRenderPassCopy(render_pass_name, data.data());
+            Std::insert(render_pass_data, render_pass_name, std::move(data));
+        }
+        dataset_writer_->submit(std::move(render_pass_data));
+        return true;
+    }
+
+    // wait for the client to release a slot, the captures for the next pose are already in flight on the render thread
+    void* data = shared_memory_mapped_region_.get_address();
+    uint8_t* slot = static_cast<uint8_t*>(SharedMemoryFrameRing::tryBeginWrite(data));
+    auto wait_begin_time = std::chrono::steady_clock::now();
+    while (!slot && std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_begin_time).count() < timeout) {
+        std::this_thread::yield();
+        slot = static_cast<uint8_t*>(SharedMemoryFrameRing::tryBeginWrite(data));
+    }
+    if (!slot) {
+        return false;
+    }
+
+    *reinterpret_cast<uint64_t*>(slot) = pose_index;
+    for (auto& [render_pass_name, render_pass_offset] : render_pass_offsets_) {
+        readRenderPassCopy(render_pass_name, slot + render_pass_offset);
+    }
+
+    SharedMemoryFrameRing::endWrite(data);
+    return true;
+}
+
+void TrajectoryRenderer::readRenderPassCopy(const std::string& render_pass_name, void* dest_ptr)
+{
+    SP_ASSERT(dest_ptr);
+
+    const RenderPassDesc& render_pass_desc = camera_sensor_->render_pass_descs_.at(render_pass_name);
+    bool compact = !render_pass_desc.readback_buffer_.empty();
+    void* readback_ptr = compact ? render_pass_desc.readback_buffer_.data() : dest_ptr;
+
+    readback_queues_.at(render_pass_name)->readOldest(readback_ptr);
+
+    if (compact) {
+        RenderPassCompaction::compact(
+            render_pass_desc.output_format_, readback_ptr, dest_ptr, static_cast<uint64_t>(render_pass_desc.height_) * render_pass_desc.width_);
+    }
+}
@@ -0,0 +1,76 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint64_t
+
+#include <map>
+#include <memory> // std::unique_ptr
+#include <string>
+#include <vector>
+
+#include "SpCore/ArrayDesc.h" // TODO: remove
+#include "SpCore/Boost.h"
+
+#include "SpServices/Legacy/CameraReadbackQueue.h"
+#include "SpServices/Legacy/CameraSensor.h"
+#include "SpServices/Legacy/DatasetWriter.h"
+
+class ACameraActor;
+class UWorld;
+
+// A TrajectoryRenderer renders a batch of camera poses in a single call, and streams the resulting images into a
+// SharedMemoryFrameRing, so clients can render large datasets without a round trip per image. The name of the ring
+// is unique to each TrajectoryRenderer, and is returned in the shared_memory_name_ field of getFrameSpace(). Each slot of the ring begins with a 64-byte header containing the index of the pose within the trajectory
+// as a uint64, followed by the "trajectory.<render_pass_name>" arrays in sorted order, each aligned to
+// SharedMemoryFrameRing::ALIGNMENT. The layout must be kept in sync with python/spear/env.py.
+//
+// The client is expected to drain the ring concurrently, e.g., from a separate thread, while renderTrajectory(...)
+// is executing. If the ring is full, renderTrajectory(...) waits for the client to release a slot.
+//
+// Captures are pipelined, i.e., renderTrajectory(...) enqueues the captures and GPU copies for pose i+1 before it
+// reads back the images for pose i, so the GPU renders the next pose while the previous one is being published.
+class TrajectoryRenderer
+{
+public:
+    TrajectoryRenderer() = delete;
+    TrajectoryRenderer(UWorld* world, const std::vector<std::string>& render_pass_names, unsigned int width, unsigned int height, float fov, int num_slots);
+    ~TrajectoryRenderer();
+
+    std::map<std::string, ArrayDesc> getFrameSpace() const;
+
+    // poses is a packed array of shape [num_poses, num_pose_components], where each pose is either (x, y, z, pitch,
+    // yaw, roll) in cm and degrees, or (x, y, z, qx, qy, qz, qw). Each pose is captured num_warmup_frames times
+    // before the image is read back, so temporal effects like Lumen and anti-aliasing can converge. Returns the
+    // number of frames that were published, which is less than the number of poses if the client didn't release
+    // a slot within timeout seconds.
+    int renderTrajectory(const std::vector<double>& poses, int num_pose_components, int num_warmup_frames, double timeout);
+
+    // While a DatasetWriter exists, renderTrajectory(...) submits each frame to it instead of writing it into the
+    // frame ring, so the client doesn't need to read any frames.
+    void createDatasetWriter(const std::string& directory, const std::map<std::string, std::string>& encodings);
+    void destroyDatasetWriter();
+    DatasetWriter* getDatasetWriter() { return dataset_writer_.get(); }
+
+private:
+    // Reads back the oldest pending copy of every render pass and publishes it, either to the DatasetWriter or into
+    // the next slot of the ring. Returns false if the client didn't release a slot within timeout seconds.
+    bool publishFrame(int pose_index, double timeout);
+    void readRenderPassCopy(const std::string& render_pass_name, void* dest_ptr);
+
+    ACameraActor* camera_actor_ = nullptr;
+    std::unique_ptr<CameraSensor> camera_sensor_;
+    std::unique_ptr<DatasetWriter> dataset_writer_;
+    std::map<std::string, std::unique_ptr<CameraReadbackQueue>> readback_queues_;
+
+    // offset of each render pass relative to the start of a slot
+    std::map<std::string, uint64_t> render_pass_offsets_;
+    uint64_t slot_num_bytes_ = 0;
+    int num_slots_ = -1;
+
+    std::string shared_memory_name_; // externally visible name
+    std::string shared_memory_id_;   // ID used to manage the shared memory resource internally
+    boost::interprocess::mapped_region shared_memory_mapped_region_;
+};
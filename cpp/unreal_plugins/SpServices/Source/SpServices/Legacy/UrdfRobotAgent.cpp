@@ -30,10 +30,13 @@
 #include "UrdfRobot/UrdfRobotComponent.h"
 #include "UrdfRobot/UrdfRobotPawn.h"
 
+#include "SpServices/Legacy/AgentInstance.h"
 #include "SpServices/Legacy/CameraSensor.h"
 
-UrdfRobotAgent::UrdfRobotAgent(UWorld* world)
+UrdfRobotAgent::UrdfRobotAgent(UWorld* world, int agent_index)
 {
+    agent_index_ = agent_index;
+
     FVector spawn_location = FVector::ZeroVector;
     FRotator spawn_rotation = FRotator::ZeroRotator;
     std::string spawn_mode = Config::get<std::string>("SP_SERVICES.LEGACY.URDF_ROBOT_AGENT.SPAWN_MODE");
@@ -54,8 +57,10 @@ UrdfRobotAgent::UrdfRobotAgent(UWorld* world)
     } else {
         SP_ASSERT(false);
     }
+    spawn_location += AgentInstance::getOffset(agent_index_);
+
     FActorSpawnParameters actor_spawn_params;
-    actor_spawn_params.Name = Unreal::toFName(Config::get<std::string>("SP_SERVICES.LEGACY.URDF_ROBOT_AGENT.URDF_ROBOT_ACTOR_NAME"));
+    actor_spawn_params.Name = Unreal::toFName(AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.URDF_ROBOT_AGENT.URDF_ROBOT_ACTOR_NAME"), agent_index_));
     actor_spawn_params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
     urdf_robot_pawn_ = world->SpawnActor<AUrdfRobotPawn>(spawn_location, spawn_rotation, actor_spawn_params);
     SP_ASSERT(urdf_robot_pawn_);
@@ -157,6 +162,15 @@ std::map<std::string, std::vector<uint8_t>> UrdfRobotAgent::getStepInfo() const
     return {};
 }
 
+void UrdfRobotAgent::requestSensorUpdates(const std::vector<std::string>& sensor_names)
+{
+    auto observation_components = Config::get<std::vector<std::string>>("SP_SERVICES.LEGACY.URDF_ROBOT_AGENT.OBSERVATION_COMPONENTS");
+
+    if (Std::contains(observation_components, "camera") && Std::contains(sensor_names, "camera")) {
+        camera_sensor_->requestUpdate();
+    }
+}
+
 void UrdfRobotAgent::reset()
 {
     SP_ASSERT(urdf_robot_pawn_->UrdfRobotComponent);
@@ -25,7 +25,7 @@ class UrdfRobotAgent : public Agent
 {
 public:
     UrdfRobotAgent() = delete;
-    UrdfRobotAgent(UWorld* world);
+    UrdfRobotAgent(UWorld* world, int agent_index);
     ~UrdfRobotAgent();
 
     void findObjectReferences(UWorld* world) override;
@@ -38,11 +38,14 @@ public:
     void applyAction(const std::map<std::string, std::vector<uint8_t>>& action) override;
     std::map<std::string, std::vector<uint8_t>> getObservation() const override;
     std::map<std::string, std::vector<uint8_t>> getStepInfo() const override;
+    void requestSensorUpdates(const std::vector<std::string>& sensor_names) override;
 
     void reset() override;
     bool isReady() const override;
 
 private:
+    int agent_index_ = 0;
+
     AUrdfRobotPawn* urdf_robot_pawn_ = nullptr;
 
     std::unique_ptr<CameraSensor> camera_sensor_;
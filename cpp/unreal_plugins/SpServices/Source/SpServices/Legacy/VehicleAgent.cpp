@@ -8,6 +8,7 @@
 
 #include <map>
 #include <memory> // std::make_unique
+#include <span>
 #include <string>
 #include <vector>
 
@@ -28,11 +29,15 @@
 #include "Vehicle/VehicleMovementComponent.h"
 #include "Vehicle/VehiclePawn.h"
 
+#include "SpServices/Legacy/AgentInstance.h"
 #include "SpServices/Legacy/CameraSensor.h"
 #include "SpServices/Legacy/ImuSensor.h"
+#include "SpServices/Legacy/LidarSensor.h"
 
-VehicleAgent::VehicleAgent(UWorld* world)
+VehicleAgent::VehicleAgent(UWorld* world, int agent_index)
 {
+    agent_index_ = agent_index;
+
     FVector spawn_location = FVector::ZeroVector;
     FRotator spawn_rotation = FRotator::ZeroRotator;
     auto spawn_mode = Config::get<std::string>("SP_SERVICES.LEGACY.VEHICLE_AGENT.SPAWN_MODE");
@@ -53,8 +58,10 @@ VehicleAgent::VehicleAgent(UWorld* world)
     } else {
         SP_ASSERT(false);
     }
+    spawn_location += AgentInstance::getOffset(agent_index_);
+
     FActorSpawnParameters actor_spawn_parameters;
-    actor_spawn_parameters.Name = Unreal::toFName(Config::get<std::string>("SP_SERVICES.LEGACY.VEHICLE_AGENT.VEHICLE_ACTOR_NAME"));
+    actor_spawn_parameters.Name = Unreal::toFName(AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.VEHICLE_AGENT.VEHICLE_ACTOR_NAME"), agent_index_));
     actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
     vehicle_pawn_ = world->SpawnActor<AVehiclePawn>(spawn_location, spawn_rotation, actor_spawn_parameters);
     SP_ASSERT(vehicle_pawn_);
@@ -64,7 +71,7 @@ VehicleAgent::VehicleAgent(UWorld* world)
     // Unreal::findActor interface. So we set the stable name of our VehiclePawn instance here, but we
     // don't do this in any other Agent constructors. This is an acceptable solution because we'll be
     // removing our Agent interface soon anyway.
-    Unreal::setStableName(vehicle_pawn_, Config::get<std::string>("SP_SERVICES.LEGACY.VEHICLE_AGENT.VEHICLE_ACTOR_NAME"));
+    Unreal::setStableName(vehicle_pawn_, AgentInstance::getName(Config::get<std::string>("SP_SERVICES.LEGACY.VEHICLE_AGENT.VEHICLE_ACTOR_NAME"), agent_index_));
 
     vehicle_pawn_->CameraComponent->FieldOfView =
         Config::get<float>("SP_SERVICES.LEGACY.VEHICLE_AGENT.CAMERA.FOV");
@@ -94,6 +101,11 @@ VehicleAgent::VehicleAgent(UWorld* world)
         imu_sensor_ = std::make_unique<ImuSensor>(vehicle_pawn_->ImuComponent);
         SP_ASSERT(imu_sensor_);
     }
+
+    if (Std::contains(observation_components, "lidar")) {
+        lidar_sensor_ = std::make_unique<LidarSensor>(vehicle_pawn_->CameraComponent);
+        SP_ASSERT(lidar_sensor_);
+    }
 }
 
 VehicleAgent::~VehicleAgent()
@@ -102,6 +114,11 @@ VehicleAgent::~VehicleAgent()
 
     auto observation_components = Config::get<std::vector<std::string>>("SP_SERVICES.LEGACY.VEHICLE_AGENT.OBSERVATION_COMPONENTS");
 
+    if (Std::contains(observation_components, "lidar")) {
+        SP_ASSERT(lidar_sensor_);
+        lidar_sensor_ = nullptr;
+    }
+
     if (Std::contains(observation_components, "imu")) {
         SP_ASSERT(imu_sensor_);
         imu_sensor_ = nullptr;
@@ -140,6 +157,10 @@ std::map<std::string, ArrayDesc> VehicleAgent::getObservationSpace() const
         Std::insert(observation_space, imu_sensor_->getObservationSpace());
     }
 
+    if (Std::contains(observation_components, "lidar")) {
+        Std::insert(observation_space, lidar_sensor_->getObservationSpace());
+    }
+
     return observation_space;
 }
 
@@ -160,6 +181,13 @@ std::map<std::string, std::vector<uint8_t>> VehicleAgent::getObservation() const
 
     Std::insert(observation, vehicle_pawn_->getObservation());
 
+    // VehiclePawn returns its location relative to the world frame, but agents return locations relative to their offset
+    if (Std::containsKey(observation, "location")) {
+        std::span<const double> location_data = Std::reinterpretAsSpanOf<const double>(observation.at("location"));
+        FVector location = FVector(Std::at(location_data, 0), Std::at(location_data, 1), Std::at(location_data, 2)) - AgentInstance::getOffset(agent_index_);
+        observation.at("location") = Std::reinterpretAsVector<uint8_t, double>({location.X, location.Y, location.Z});
+    }
+
     if (Std::contains(observation_components, "camera")) {
         Std::insert(observation, camera_sensor_->getObservation());
     }
@@ -168,6 +196,10 @@ std::map<std::string, std::vector<uint8_t>> VehicleAgent::getObservation() const
         Std::insert(observation, imu_sensor_->getObservation());
     }
 
+    if (Std::contains(observation_components, "lidar")) {
+        Std::insert(observation, lidar_sensor_->getObservation());
+    }
+
     return observation;
 }
 
@@ -176,6 +208,19 @@ std::map<std::string, std::vector<uint8_t>> VehicleAgent::getStepInfo() const
     return {};
 }
 
+void VehicleAgent::requestSensorUpdates(const std::vector<std::string>& sensor_names)
+{
+    auto observation_components = Config::get<std::vector<std::string>>("SP_SERVICES.LEGACY.VEHICLE_AGENT.OBSERVATION_COMPONENTS");
+
+    if (Std::contains(observation_components, "camera") && Std::contains(sensor_names, "camera")) {
+        camera_sensor_->requestUpdate();
+    }
+
+    if (Std::contains(observation_components, "imu") && Std::contains(sensor_names, "imu")) {
+        imu_sensor_->requestUpdate();
+    }
+}
+
 void VehicleAgent::reset()
 {
     vehicle_pawn_->GetVehicleMovementComponent()->ResetVehicle();
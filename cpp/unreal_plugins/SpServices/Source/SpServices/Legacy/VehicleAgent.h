@@ -21,12 +21,13 @@ class UWorld;
 class AVehiclePawn;
 class CameraSensor;
 class ImuSensor;
+class LidarSensor;
 
 class VehicleAgent : public Agent
 {
 public:
     VehicleAgent() = delete;
-    VehicleAgent(UWorld* world);
+    VehicleAgent(UWorld* world, int agent_index);
     ~VehicleAgent();
 
     void findObjectReferences(UWorld* world) override;
@@ -39,15 +40,19 @@ public:
     void applyAction(const std::map<std::string, std::vector<uint8_t>>& action) override;
     std::map<std::string, std::vector<uint8_t>> getObservation() const override;
     std::map<std::string, std::vector<uint8_t>> getStepInfo() const override;
+    void requestSensorUpdates(const std::vector<std::string>& sensor_names) override;
 
     void reset() override;
     bool isReady() const override;
 
 private:
+    int agent_index_ = 0;
+
     AVehiclePawn* vehicle_pawn_ = nullptr;
 
     std::unique_ptr<CameraSensor> camera_sensor_;
     std::unique_ptr<ImuSensor> imu_sensor_;
+    std::unique_ptr<LidarSensor> lidar_sensor_;
 
     inline static auto s_class_registration_handler_ = ClassRegistrationUtils::registerClass<VehicleAgent>(Agent::s_class_registrar_, "VehicleAgent");
 };
@@ -4,25 +4,38 @@
 
 #include "SpServices/LegacyService.h"
 
+#include <stdint.h> // int64_t, uint8_t, uint64_t
+
+#include <map>
+#include <memory>  // std::make_unique, std::unique_ptr
 #include <string>
+#include <utility> // std::move
 #include <vector>
 
 #include <Delegates/IDelegateInstance.h> // FDelegateHandle
 #include <Engine/Engine.h>               // GEngine
+#include <Engine/GameViewportClient.h>
+#include <Engine/StreamableManager.h>    // FStreamableDelegate, FStreamableManager
 #include <Engine/World.h>                // UWorld
 #include <Kismet/GameplayStatics.h>
 #include <Misc/App.h>
+#include <Misc/CoreDelegates.h>
 #include <PhysicsEngine/PhysicsSettings.h>
+#include <UObject/SoftObjectPath.h>      // FSoftObjectPath
 
+#include "SpCore/ArrayDesc.h" // TODO: remove
 #include "SpCore/Assert.h"
 #include "SpCore/Config.h"
 #include "SpCore/Log.h"
+#include "SpCore/Std.h"
 #include "SpCore/Unreal.h"
 
 #include "SpServices/EngineService.h"
 
+#include "SpServices/Legacy/ActionLog.h"
 #include "SpServices/Legacy/Agent.h"
 #include "SpServices/Legacy/CameraAgent.h"
+#include "SpServices/Legacy/CameraSensor.h"
 #include "SpServices/Legacy/ClassRegistrationUtils.h"
 #include "SpServices/Legacy/ImitationLearningTask.h"
 #include "SpServices/Legacy/NavMesh.h"
@@ -30,6 +43,7 @@
 #include "SpServices/Legacy/NullTask.h"
 #include "SpServices/Legacy/SphereAgent.h"
 #include "SpServices/Legacy/Task.h"
+#include "SpServices/Legacy/TrajectoryRenderer.h"
 #include "SpServices/Legacy/UrdfRobotAgent.h"
 #include "SpServices/Legacy/VehicleAgent.h"
 
@@ -42,18 +56,20 @@ void LegacyService::postWorldInitializationHandler(UWorld* world, const UWorld::
         std::string scene_id = "";
         std::string map_id = "";
 
-        if (Config::isInitialized()) {
+        if (scene_id_override_ != "") {
+            scene_id = scene_id_override_;
+            map_id = map_id_override_;
+        } else if (Config::isInitialized()) {
             scene_id = Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.SCENE_ID");
             map_id = Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.MAP_ID");
         }
 
-        std::string desired_world_path_name = "";
         std::string desired_level_name = "";
         if (scene_id != "") {
             if (map_id == "") {
                 map_id = scene_id;
             }
-            desired_level_name = "/Game/Scenes/" + scene_id + "/Maps/" + map_id;
+            desired_level_name = getLevelName(scene_id, map_id);
         }
 
         bool open_level = scene_id != "" && scene_id != Unreal::toStdString(world->GetName());
@@ -79,6 +95,14 @@ void LegacyService::postWorldInitializationHandler(UWorld* world, const UWorld::
             SP_ASSERT(!world_);
             world_ = world;
             world_begin_play_handle_ = world_->OnWorldBeginPlay.AddRaw(this, &LegacyService::worldBeginPlayHandler);
+
+            // once the preloaded scene has been opened, the world holds references to everything it needs, so we
+            // can release our handle, we keep preload_scene_level_name_ so clients can still query the preload's status
+            if (preload_scene_handle_.IsValid() && preload_scene_level_name_ == desired_level_name) {
+                SP_LOG("Releasing preloaded scene: ", preload_scene_level_name_);
+                preload_scene_handle_->ReleaseHandle();
+                preload_scene_handle_ = nullptr;
+            }
         }
     }
 }
@@ -90,20 +114,31 @@ void LegacyService::worldCleanupHandler(UWorld* world, bool session_ended, bool
 
     if (world == world_) {
 
+        // a replay refers to our agents and tasks, so it can't outlive the world
+        if (action_log_reader_) {
+            stopReplay();
+        }
+
         if (has_world_begin_play_executed_) {
             has_world_begin_play_executed_ = false;
 
+            trajectory_renderer_ = nullptr;
+
             SP_ASSERT(nav_mesh_);
             nav_mesh_->cleanUpObjectReferences();
             nav_mesh_ = nullptr;
 
-            SP_ASSERT(task_);
-            task_->cleanUpObjectReferences();
-            task_ = nullptr;
+            SP_ASSERT(!tasks_.empty());
+            for (auto& task : tasks_) {
+                task->cleanUpObjectReferences();
+            }
+            tasks_.clear();
 
-            SP_ASSERT(agent_);
-            agent_->cleanUpObjectReferences();
-            agent_ = nullptr;
+            SP_ASSERT(!agents_.empty());
+            for (auto& agent : agents_) {
+                agent->cleanUpObjectReferences();
+            }
+            agents_.clear();
         }
 
         world_->OnWorldBeginPlay.Remove(world_begin_play_handle_);
@@ -157,28 +192,429 @@ void LegacyService::worldBeginPlayHandler()
     UGameplayStatics::SetGamePaused(world_, true);
 
     if (Config::isInitialized()) {
-        agent_ = std::unique_ptr<Agent>(ClassRegistrationUtils::create(Agent::s_class_registrar_, Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.AGENT"), world_));
+        setRenderingEnabled(Config::get<bool>("SP_SERVICES.LEGACY_SERVICE.ENABLE_RENDERING"));
+    } else {
+        setRenderingEnabled(true);
+    }
 
-        if (Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.TASK") == "NullTask") {
-            task_ = std::make_unique<NullTask>();
-        } else if (Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.TASK") == "ImitationLearningTask") {
-            task_ = std::make_unique<ImitationLearningTask>(world_);
+    int num_agents = 1;
+    if (Config::isInitialized()) {
+        num_agents = Config::get<int>("SP_SERVICES.LEGACY_SERVICE.NUM_AGENTS");
+    }
+    SP_ASSERT(num_agents >= 1);
+
+    // Vectorized observations are returned by concatenating each agent's arrays, so we can't support sensors that
+    // write their arrays into shared memory, because every agent's sensor would try to use the same shared memory name.
+    if (num_agents > 1) {
+        SP_ASSERT(!Config::get<bool>("SP_SERVICES.LEGACY.CAMERA_SENSOR.USE_SHARED_MEMORY"));
+        SP_ASSERT(!Config::get<bool>("SP_SERVICES.LEGACY.LIDAR_SENSOR.USE_SHARED_MEMORY"));
+    }
+
+    for (int i = 0; i < num_agents; i++) {
+        std::unique_ptr<Agent> agent = nullptr;
+        std::unique_ptr<Task> task = nullptr;
+
+        if (Config::isInitialized()) {
+            agent = std::unique_ptr<Agent>(ClassRegistrationUtils::create(Agent::s_class_registrar_, Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.AGENT"), world_, i));
+
+            if (Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.TASK") == "NullTask") {
+                task = std::make_unique<NullTask>();
+            } else if (Config::get<std::string>("SP_SERVICES.LEGACY_SERVICE.TASK") == "ImitationLearningTask") {
+                task = std::make_unique<ImitationLearningTask>(world_, i);
+            } else {
+                SP_ASSERT(false);
+            }
         } else {
-            SP_ASSERT(false);
+            agent = std::unique_ptr<Agent>(ClassRegistrationUtils::create(Agent::s_class_registrar_, "NullAgent", world_, i));
+            task = std::make_unique<NullTask>();
         }
-    } else {
-        agent_ = std::unique_ptr<Agent>(ClassRegistrationUtils::create(Agent::s_class_registrar_, "NullAgent", world_));
-        task_ = std::make_unique<NullTask>();
+        SP_ASSERT(agent);
+        SP_ASSERT(task);
+
+        agents_.push_back(std::move(agent));
+        tasks_.push_back(std::move(task));
     }
-    SP_ASSERT(agent_);
-    SP_ASSERT(task_);
 
     nav_mesh_ = std::make_unique<NavMesh>();
     SP_ASSERT(nav_mesh_);
 
-    agent_->findObjectReferences(world_);
-    task_->findObjectReferences(world_);
+    for (auto& agent : agents_) {
+        agent->findObjectReferences(world_);
+    }
+    for (auto& task : tasks_) {
+        task->findObjectReferences(world_);
+    }
     nav_mesh_->findObjectReferences(world_);
 
     has_world_begin_play_executed_ = true;
 }
+
+void LegacyService::recordCall(ActionLogRecordType type, const std::map<std::string, std::vector<uint8_t>>& arrays)
+{
+    if (!action_log_writer_) {
+        return;
+    }
+
+    // the Tick record for the current frame must precede all other records for the frame
+    recordTick();
+
+    ActionLogRecordPhase phase = get_frame_state_func_() == FrameState::ExecutingPostTick ? ActionLogRecordPhase::PostTick : ActionLogRecordPhase::PreTick;
+    action_log_writer_->writeRecord(type, phase, get_frame_index_func_() - recording_start_frame_index_, arrays);
+}
+
+void LegacyService::recordTick()
+{
+    SP_ASSERT(action_log_writer_);
+
+    // the frame index only advances once per call to begin_tick, so there is at most one frame without a Tick record
+    uint64_t frame_index = get_frame_index_func_() - recording_start_frame_index_;
+    if (frame_index < recording_num_frames_) {
+        return;
+    }
+    SP_ASSERT(frame_index == recording_num_frames_);
+
+    action_log_writer_->writeRecord(ActionLogRecordType::Tick, ActionLogRecordPhase::PreTick, frame_index);
+    recording_num_frames_++;
+}
+
+void LegacyService::startRecording(const std::string& file)
+{
+    SP_ASSERT(!action_log_writer_);
+    SP_ASSERT(!action_log_reader_);
+
+    action_log_writer_ = std::make_unique<ActionLogWriter>(file);
+    recording_start_frame_index_ = get_frame_index_func_();
+
+    // Tasks might have been reset before recording started, so we record their reset state, otherwise a replay
+    // would start from each task's initial state and produce different episodes.
+    std::map<std::string, std::vector<uint8_t>> reset_states;
+    for (int i = 0; i < tasks_.size(); i++) {
+        Std::insert(reset_states, Std::toString(i), tasks_.at(i)->getResetState());
+    }
+    action_log_writer_->writeRecord(ActionLogRecordType::Start, ActionLogRecordPhase::PreTick, 0, reset_states);
+
+    // Frames where the client doesn't call any of our entry points still need a Tick record, so a replay ticks the
+    // engine exactly as often as the recording did. We can't rely on recordCall(...) for these frames, so we also
+    // write Tick records from an FCoreDelegates::OnBeginFrame handler.
+    recording_num_frames_ = 0;
+    recordTick();
+    recording_begin_frame_handle_ = FCoreDelegates::OnBeginFrame.AddRaw(this, &LegacyService::recordingBeginFrameHandler);
+}
+
+void LegacyService::stopRecording()
+{
+    SP_ASSERT(action_log_writer_);
+
+    FCoreDelegates::OnBeginFrame.Remove(recording_begin_frame_handle_);
+    recording_begin_frame_handle_.Reset();
+
+    // our OnBeginFrame handler might not have executed yet for the current frame
+    recordTick();
+
+    action_log_writer_->close(get_frame_index_func_() - recording_start_frame_index_);
+    action_log_writer_ = nullptr;
+}
+
+void LegacyService::recordingBeginFrameHandler()
+{
+    recordTick();
+}
+
+void LegacyService::startReplay(const std::string& file, const std::string& observation_file)
+{
+    SP_ASSERT(world_);
+    SP_ASSERT(!action_log_writer_);
+    SP_ASSERT(!action_log_reader_);
+
+    action_log_reader_ = std::make_unique<ActionLogReader>(file);
+
+    // restore the reset state of each task before replaying any other records, see startRecording(...)
+    SP_ASSERT(!action_log_reader_->isAtEnd());
+    SP_ASSERT(action_log_reader_->getRecordHeader().type_ == ActionLogRecordType::Start);
+    std::map<std::string, std::vector<uint8_t>> reset_states = action_log_reader_->getRecordArrays();
+    SP_ASSERT(reset_states.size() == tasks_.size());
+    for (int i = 0; i < tasks_.size(); i++) {
+        tasks_.at(i)->setResetState(reset_states.at(Std::toString(i)));
+    }
+    action_log_reader_->next();
+    if (observation_file != "") {
+        replay_observation_writer_ = std::make_unique<ActionLogWriter>(observation_file);
+    }
+
+    replay_frame_index_ = 0;
+    has_replay_begun_frame_ = false;
+    is_replay_done_ = false;
+
+    // We might be executing inside an FCoreDelegates::OnBeginFrame or FCoreDelegates::OnEndFrame broadcast, so
+    // replayEndFrameHandler() ignores the current frame until replayBeginFrameHandler() has been called.
+    replay_begin_frame_handle_ = FCoreDelegates::OnBeginFrame.AddRaw(this, &LegacyService::replayBeginFrameHandler);
+    replay_end_frame_handle_ = FCoreDelegates::OnEndFrame.AddRaw(this, &LegacyService::replayEndFrameHandler);
+}
+
+void LegacyService::stopReplay()
+{
+    SP_ASSERT(action_log_reader_);
+
+    FCoreDelegates::OnEndFrame.Remove(replay_end_frame_handle_);
+    FCoreDelegates::OnBeginFrame.Remove(replay_begin_frame_handle_);
+    replay_end_frame_handle_.Reset();
+    replay_begin_frame_handle_.Reset();
+
+    if (replay_observation_writer_) {
+        replay_observation_writer_->close(replay_frame_index_);
+        replay_observation_writer_ = nullptr;
+    }
+    action_log_reader_ = nullptr;
+
+    // the game is paused between calls to end_tick and begin_tick, so we pause it again when we're done
+    if (world_ && has_replay_begun_frame_) {
+        UGameplayStatics::SetGamePaused(world_, true);
+    }
+
+    is_replay_done_ = true;
+}
+
+void LegacyService::replayBeginFrameHandler()
+{
+    if (!has_replay_begun_frame_) {
+        SP_ASSERT(world_);
+        UGameplayStatics::SetGamePaused(world_, false);
+        has_replay_begun_frame_ = true;
+    }
+
+    // every recorded frame begins with a Tick record, so the replay stays in lockstep with the recording
+    SP_ASSERT(!action_log_reader_->isAtEnd());
+    SP_ASSERT(action_log_reader_->getRecordHeader().type_ == ActionLogRecordType::Tick);
+    SP_ASSERT(action_log_reader_->getRecordHeader().frame_index_ == replay_frame_index_);
+
+    replayRecords(ActionLogRecordPhase::PreTick);
+}
+
+void LegacyService::replayEndFrameHandler()
+{
+    if (!has_replay_begun_frame_) {
+        return;
+    }
+
+    replayRecords(ActionLogRecordPhase::PostTick);
+    replay_frame_index_++;
+
+    if (action_log_reader_->isAtEnd()) {
+        stopReplay();
+    }
+}
+
+void LegacyService::replayRecords(ActionLogRecordPhase phase)
+{
+    // Records are stored in the order they were recorded, so all of the pre-tick records for a frame are followed
+    // by all of the post-tick records for that frame.
+    while (!action_log_reader_->isAtEnd()) {
+        ActionLogRecordHeader record_header = action_log_reader_->getRecordHeader();
+        SP_ASSERT(record_header.frame_index_ >= replay_frame_index_);
+        if (record_header.frame_index_ != replay_frame_index_ || record_header.phase_ != phase) {
+            return;
+        }
+
+        switch (record_header.type_) {
+            case ActionLogRecordType::Tick:
+                break;
+            case ActionLogRecordType::ApplyAction:
+                SP_ASSERT(agents_.size() == 1);
+                agents_.at(0)->applyAction(action_log_reader_->getRecordArrays());
+                break;
+            case ActionLogRecordType::GetObservation:
+                SP_ASSERT(agents_.size() == 1);
+                if (replay_observation_writer_) {
+                    replay_observation_writer_->writeRecord(ActionLogRecordType::GetObservation, phase, replay_frame_index_, agents_.at(0)->getObservation());
+                }
+                break;
+            case ActionLogRecordType::ResetAgent:
+                SP_ASSERT(agents_.size() == 1);
+                agents_.at(0)->reset();
+                break;
+            case ActionLogRecordType::ResetTask:
+                SP_ASSERT(tasks_.size() == 1);
+                tasks_.at(0)->reset();
+                break;
+            case ActionLogRecordType::ApplyVectorizedAction:
+                applyVectorizedAction(action_log_reader_->getRecordArrays());
+                break;
+            case ActionLogRecordType::GetVectorizedObservation:
+                if (replay_observation_writer_) {
+                    replay_observation_writer_->writeRecord(ActionLogRecordType::GetVectorizedObservation, phase, replay_frame_index_, getVectorizedObservation());
+                }
+                break;
+            case ActionLogRecordType::AutoResetVectorized:
+                autoResetVectorized();
+                break;
+            case ActionLogRecordType::ResetVectorized:
+                resetVectorized();
+                break;
+            default:
+                SP_ASSERT(false);
+        }
+
+        action_log_reader_->next();
+    }
+}
+
+void LegacyService::preloadScene(const std::string& scene_id, const std::string& map_id)
+{
+    SP_ASSERT(scene_id != "");
+
+    std::string level_name = getLevelName(scene_id, map_id == "" ? scene_id : map_id);
+    if (preload_scene_handle_.IsValid()) {
+        if (preload_scene_level_name_ == level_name) {
+            return;
+        }
+        preload_scene_handle_->ReleaseHandle();
+        preload_scene_handle_ = nullptr;
+    }
+
+    // FStreamableManager loads the map package and all of its dependencies via LoadPackageAsync(...) without
+    // blocking the game thread. We pass bManageActiveHandle=true so the loaded objects are kept alive, in particular
+    // across the garbage collection pass that happens when the current world is torn down, until we release the
+    // handle after the preloaded scene has been opened.
+    SP_LOG("Preloading scene: ", level_name);
+    std::string map_name = level_name.substr(level_name.find_last_of("/") + 1);
+    FSoftObjectPath soft_object_path(Unreal::toFString(level_name + "." + map_name));
+    bool manage_active_handle = true;
+    preload_scene_handle_ = streamable_manager_.RequestAsyncLoad(
+        soft_object_path, FStreamableDelegate(), FStreamableManager::DefaultAsyncLoadPriority, manage_active_handle);
+    SP_ASSERT(preload_scene_handle_.IsValid());
+    preload_scene_level_name_ = level_name;
+}
+
+void LegacyService::switchScene(const std::string& scene_id, const std::string& map_id)
+{
+    SP_ASSERT(world_);
+    SP_ASSERT(scene_id != "");
+    SP_ASSERT(!open_level_pending_);
+
+    std::string level_name = getLevelName(scene_id, map_id == "" ? scene_id : map_id);
+
+    // If the scene is still being preloaded, finish loading it here rather than letting OpenLevel(...) start a
+    // second, blocking load of the same package.
+    if (preload_scene_handle_.IsValid() && preload_scene_level_name_ == level_name) {
+        preload_scene_handle_->WaitUntilComplete();
+    }
+
+    scene_id_override_ = scene_id;
+    map_id_override_ = map_id;
+
+    SP_LOG("Switching to scene: ", level_name);
+    UGameplayStatics::OpenLevel(world_, Unreal::toFName(level_name));
+}
+
+std::string LegacyService::getLevelName(const std::string& scene_id, const std::string& map_id)
+{
+    return "/Game/Scenes/" + scene_id + "/Maps/" + map_id;
+}
+
+void LegacyService::setRenderingEnabled(bool enabled)
+{
+    rendering_enabled_ = enabled;
+
+    // skip drawing the world into the game viewport, but keep drawing the viewport itself, so the window stays responsive
+    if (GEngine->GameViewport) {
+        GEngine->GameViewport->bDisableWorldRendering = !enabled;
+    }
+
+    // skip scene captures and GPU readbacks
+    CameraSensor::setRenderingEnabled(enabled);
+}
+
+std::map<std::string, ArrayDesc> LegacyService::getVectorizedSpace(const std::map<std::string, ArrayDesc>& space) const
+{
+    std::map<std::string, ArrayDesc> vectorized_space;
+    for (auto& [name, array_desc] : space) {
+        SP_ASSERT(!array_desc.use_shared_memory_);
+
+        // stackArrays(...) requires every agent's array to have the same size, so we can't vectorize arrays whose
+        // size can change from one step to the next (e.g., imu.substep_samples)
+        if (Std::contains(array_desc.shape_, -1)) {
+            SP_LOG("ERROR: Can't vectorize variable-length array: ", name);
+            SP_ASSERT(false);
+        }
+
+        ArrayDesc vectorized_array_desc = array_desc;
+        vectorized_array_desc.shape_.insert(vectorized_array_desc.shape_.begin(), static_cast<int64_t>(agents_.size()));
+        Std::insert(vectorized_space, name, std::move(vectorized_array_desc));
+    }
+    return vectorized_space;
+}
+
+void LegacyService::applyVectorizedAction(const std::map<std::string, std::vector<uint8_t>>& action)
+{
+    SP_ASSERT(!agents_.empty());
+
+    // split each stacked array into one equally sized array per agent
+    std::vector<std::map<std::string, std::vector<uint8_t>>> agent_actions(agents_.size());
+    for (auto& [name, data] : action) {
+        SP_ASSERT(data.size() % agents_.size() == 0);
+        uint64_t num_bytes = data.size() / agents_.size();
+        for (int i = 0; i < agents_.size(); i++) {
+            Std::insert(agent_actions.at(i), name, std::vector<uint8_t>(data.begin() + i*num_bytes, data.begin() + (i + 1)*num_bytes));
+        }
+    }
+
+    for (int i = 0; i < agents_.size(); i++) {
+        agents_.at(i)->applyAction(agent_actions.at(i));
+    }
+}
+
+std::vector<uint8_t> LegacyService::autoResetVectorized()
+{
+    SP_ASSERT(agents_.size() == tasks_.size());
+
+    std::vector<uint8_t> episode_done_flags(agents_.size());
+    for (int i = 0; i < agents_.size(); i++) {
+        episode_done_flags.at(i) = tasks_.at(i)->isEpisodeDone();
+
+        // reset the task first in case it needs to set the pose of actors, then reset the agent so it can refine the
+        // pose of actors, as in spear.Env
+        if (episode_done_flags.at(i)) {
+            tasks_.at(i)->reset();
+            agents_.at(i)->reset();
+        }
+    }
+    return episode_done_flags;
+}
+
+std::map<std::string, std::vector<uint8_t>> LegacyService::getVectorizedObservation()
+{
+    std::vector<std::map<std::string, std::vector<uint8_t>>> observations;
+    for (auto& agent : agents_) {
+        observations.push_back(agent->getObservation());
+    }
+    return stackArrays(observations);
+}
+
+void LegacyService::resetVectorized()
+{
+    SP_ASSERT(agents_.size() == tasks_.size());
+    for (int i = 0; i < agents_.size(); i++) {
+        tasks_.at(i)->reset();
+        agents_.at(i)->reset();
+    }
+}
+
+std::map<std::string, std::vector<uint8_t>> LegacyService::stackArrays(const std::vector<std::map<std::string, std::vector<uint8_t>>>& arrays)
+{
+    std::map<std::string, std::vector<uint8_t>> stacked_arrays;
+    if (arrays.empty()) {
+        return stacked_arrays;
+    }
+
+    for (auto& [name, data] : arrays.at(0)) {
+        std::vector<uint8_t> stacked_data;
+        stacked_data.reserve(data.size() * arrays.size());
+        for (auto& array : arrays) {
+            const std::vector<uint8_t>& agent_data = array.at(name);
+            SP_ASSERT(agent_data.size() == data.size());
+            stacked_data.insert(stacked_data.end(), agent_data.begin(), agent_data.end());
+        }
+        Std::insert(stacked_arrays, name, std::move(stacked_data));
+    }
+    return stacked_arrays;
+}
@@ -4,22 +4,33 @@
 
 #pragma once
 
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <atomic>
+#include <functional> // std::function
+#include <map>
+#include <memory>     // std::make_unique, std::unique_ptr
 #include <string>
 #include <vector>
 
 #include <Delegates/IDelegateInstance.h> // FDelegateHandle
+#include <Engine/StreamableManager.h>    // FStreamableHandle, FStreamableManager
 #include <Engine/World.h>                // FWorldDelegates
+#include <Templates/SharedPointer.h>     // TSharedPtr
 
 #include "SpCore/ArrayDesc.h" // TODO: remove
 #include "SpCore/Assert.h"
 
+#include "SpServices/EngineService.h"
 #include "SpServices/EntryPointBinder.h"
 #include "SpServices/Msgpack.h"
 #include "SpServices/Rpclib.h"
 
+#include "SpServices/Legacy/ActionLog.h"
 #include "SpServices/Legacy/Agent.h"
 #include "SpServices/Legacy/NavMesh.h"
 #include "SpServices/Legacy/Task.h"
+#include "SpServices/Legacy/TrajectoryRenderer.h"
 
 class LegacyService {
 public:
@@ -29,74 +40,285 @@ public:
         post_world_initialization_handle_ = FWorldDelegates::OnPostWorldInitialization.AddRaw(this, &LegacyService::postWorldInitializationHandler);
         world_cleanup_handle_ = FWorldDelegates::OnWorldCleanup.AddRaw(this, &LegacyService::worldCleanupHandler);
 
+        // needed to tag recorded calls with the frame they were made in, see ActionLog.h
+        get_frame_index_func_ = [unreal_entry_point_binder]() -> uint64_t { return unreal_entry_point_binder->getFrameIndex(); };
+        get_frame_state_func_ = [unreal_entry_point_binder]() -> FrameState { return unreal_entry_point_binder->getFrameState(); };
+
         unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_action_space", [this]() -> std::map<std::string, ArrayDesc> {
-            SP_ASSERT(agent_);
-            return agent_->getActionSpace();
+            SP_ASSERT(agents_.size() == 1);
+            return agents_.at(0)->getActionSpace();
         });
 
         unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_observation_space", [this]() -> std::map<std::string, ArrayDesc> {
-            SP_ASSERT(agent_);
-            return agent_->getObservationSpace();
+            SP_ASSERT(agents_.size() == 1);
+            return agents_.at(0)->getObservationSpace();
         });
 
         unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_agent_step_info_space", [this]() -> std::map<std::string, ArrayDesc> {
-            SP_ASSERT(agent_);
-            return agent_->getStepInfoSpace();
+            SP_ASSERT(agents_.size() == 1);
+            return agents_.at(0)->getStepInfoSpace();
         });
 
         unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_task_step_info_space", [this]() -> std::map<std::string, ArrayDesc> {
-            SP_ASSERT(task_);
-            return task_->getStepInfoSpace();
+            SP_ASSERT(tasks_.size() == 1);
+            return tasks_.at(0)->getStepInfoSpace();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "apply_action", [this](std::map<std::string, std::vector<uint8_t>>& action) -> void {
-            SP_ASSERT(agent_);
-            agent_->applyAction(action);
+            SP_ASSERT(agents_.size() == 1);
+            recordCall(ActionLogRecordType::ApplyAction, action);
+            agents_.at(0)->applyAction(action);
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_observation", [this]() -> std::map<std::string, std::vector<uint8_t>> {
-            SP_ASSERT(agent_);
-            return agent_->getObservation();
+            SP_ASSERT(agents_.size() == 1);
+            recordCall(ActionLogRecordType::GetObservation);
+            return agents_.at(0)->getObservation();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "request_sensor_updates", [this](std::vector<std::string>& sensor_names) -> void {
+            SP_ASSERT(agents_.size() == 1);
+            agents_.at(0)->requestSensorUpdates(sensor_names);
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_reward", [this]() -> float {
-            SP_ASSERT(task_);
-            return task_->getReward();
+            SP_ASSERT(tasks_.size() == 1);
+            return tasks_.at(0)->getReward();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "is_episode_done", [this]() -> bool {
-            SP_ASSERT(task_);
-            return task_->isEpisodeDone();
+            SP_ASSERT(tasks_.size() == 1);
+            return tasks_.at(0)->isEpisodeDone();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_agent_step_info", [this]() -> std::map<std::string, std::vector<uint8_t>> {
-            SP_ASSERT(agent_);
-            return agent_->getStepInfo();
+            SP_ASSERT(agents_.size() == 1);
+            return agents_.at(0)->getStepInfo();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_task_step_info", [this]() -> std::map<std::string, std::vector<uint8_t>> {
-            SP_ASSERT(task_);
-            return task_->getStepInfo();
+            SP_ASSERT(tasks_.size() == 1);
+            return tasks_.at(0)->getStepInfo();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "reset_agent", [this]() -> void {
-            SP_ASSERT(agent_);
-            agent_->reset();
+            SP_ASSERT(agents_.size() == 1);
+            recordCall(ActionLogRecordType::ResetAgent);
+            agents_.at(0)->reset();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "reset_task", [this]() -> void {
-            SP_ASSERT(task_);
-            task_->reset();
+            SP_ASSERT(tasks_.size() == 1);
+            recordCall(ActionLogRecordType::ResetTask);
+            tasks_.at(0)->reset();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "is_agent_ready", [this]() -> bool {
-            SP_ASSERT(agent_);
-            return agent_->isReady();
+            SP_ASSERT(agents_.size() == 1);
+            return agents_.at(0)->isReady();
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "is_task_ready", [this]() -> bool {
-            SP_ASSERT(task_);
-            return task_->isReady();
+            SP_ASSERT(tasks_.size() == 1);
+            return tasks_.at(0)->isReady();
+        });
+
+        //
+        // Vectorized entry points, see SP_SERVICES.LEGACY_SERVICE.NUM_AGENTS. Each array is the concatenation of the
+        // corresponding array for every agent, so its shape is [num_agents, ...].
+        //
+
+        unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_num_agents", [this]() -> int {
+            return static_cast<int>(agents_.size());
+        });
+
+        unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_vectorized_action_space", [this]() -> std::map<std::string, ArrayDesc> {
+            SP_ASSERT(!agents_.empty());
+            return getVectorizedSpace(agents_.at(0)->getActionSpace());
+        });
+
+        unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_vectorized_observation_space", [this]() -> std::map<std::string, ArrayDesc> {
+            SP_ASSERT(!agents_.empty());
+            return getVectorizedSpace(agents_.at(0)->getObservationSpace());
+        });
+
+        unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_vectorized_agent_step_info_space", [this]() -> std::map<std::string, ArrayDesc> {
+            SP_ASSERT(!agents_.empty());
+            return getVectorizedSpace(agents_.at(0)->getStepInfoSpace());
+        });
+
+        unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "get_vectorized_task_step_info_space", [this]() -> std::map<std::string, ArrayDesc> {
+            SP_ASSERT(!tasks_.empty());
+            return getVectorizedSpace(tasks_.at(0)->getStepInfoSpace());
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "apply_vectorized_action", [this](std::map<std::string, std::vector<uint8_t>>& action) -> void {
+            recordCall(ActionLogRecordType::ApplyVectorizedAction, action);
+            applyVectorizedAction(action);
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_vectorized_observation", [this]() -> std::map<std::string, std::vector<uint8_t>> {
+            recordCall(ActionLogRecordType::GetVectorizedObservation);
+            return getVectorizedObservation();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_vectorized_rewards", [this]() -> std::vector<float> {
+            std::vector<float> rewards;
+            for (auto& task : tasks_) {
+                rewards.push_back(task->getReward());
+            }
+            return rewards;
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_vectorized_agent_step_info", [this]() -> std::map<std::string, std::vector<uint8_t>> {
+            std::vector<std::map<std::string, std::vector<uint8_t>>> step_infos;
+            for (auto& agent : agents_) {
+                step_infos.push_back(agent->getStepInfo());
+            }
+            return stackArrays(step_infos);
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_vectorized_task_step_info", [this]() -> std::map<std::string, std::vector<uint8_t>> {
+            std::vector<std::map<std::string, std::vector<uint8_t>>> step_infos;
+            for (auto& task : tasks_) {
+                step_infos.push_back(task->getStepInfo());
+            }
+            return stackArrays(step_infos);
+        });
+
+        // Returns a uint8 array of episode done flags, and resets the task and agent of every agent whose episode is
+        // done, so the next step begins a new episode for these agents. Call after get_vectorized_observation(),
+        // get_vectorized_rewards(), and the step info entry points, because they describe the final step of the
+        // episode.
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "auto_reset_vectorized", [this]() -> std::vector<uint8_t> {
+            recordCall(ActionLogRecordType::AutoResetVectorized);
+            return autoResetVectorized();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "reset_vectorized", [this]() -> void {
+            recordCall(ActionLogRecordType::ResetVectorized);
+            resetVectorized();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "is_vectorized_ready", [this]() -> bool {
+            SP_ASSERT(agents_.size() == tasks_.size());
+            for (int i = 0; i < agents_.size(); i++) {
+                if (!tasks_.at(i)->isReady() || !agents_.at(i)->isReady()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+
+        // preload_scene(...) streams a scene's map package and its dependencies in the background while the current
+        // episode continues, and switch_scene(...) travels to a scene, which is much faster if the scene has
+        // finished preloading. An empty map_id refers to the map with the same name as the scene.
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "preload_scene", [this](std::string& scene_id, std::string& map_id) -> void {
+            preloadScene(scene_id, map_id);
+        });
+
+        // If there is no preload handle, then either nothing has been preloaded, or the preloaded scene has already
+        // been opened and its handle has been released.
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_preload_scene_progress", [this]() -> float {
+            if (!preload_scene_handle_.IsValid()) {
+                return preload_scene_level_name_ == "" ? 0.0f : 1.0f;
+            }
+            return preload_scene_handle_->GetProgress();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "has_preload_scene_completed", [this]() -> bool {
+            if (!preload_scene_handle_.IsValid()) {
+                return preload_scene_level_name_ != "";
+            }
+            return preload_scene_handle_->HasLoadCompleted();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "switch_scene", [this](std::string& scene_id, std::string& map_id) -> void {
+            switchScene(scene_id, map_id);
+        });
+
+        //
+        // Record and replay calls to the stepping and reset entry points above, see ActionLog.h. A replay runs
+        // inside the engine as fast as it can tick, so the client should stop calling begin_tick after calling
+        // start_replay(...), and poll is_replay_done() until it returns true. If observation_file is non-empty,
+        // the observations that were returned to the client during recording are captured again during replay,
+        // and written to observation_file in the same format.
+        //
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "start_recording", [this](std::string& file) -> void {
+            startRecording(file);
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "stop_recording", [this]() -> void {
+            stopRecording();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "start_replay", [this](std::string& file, std::string& observation_file) -> void {
+            startReplay(file, observation_file);
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "stop_replay", [this]() -> void {
+            stopReplay();
+        });
+
+        // doesn't need to run on the game thread, so it can be polled without calling begin_tick
+        unreal_entry_point_binder->bindFuncNoUnreal("legacy_service", "is_replay_done", [this]() -> bool {
+            return is_replay_done_;
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "set_rendering_enabled", [this](bool& enabled) -> void {
+            setRenderingEnabled(enabled);
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "is_rendering_enabled", [this]() -> bool {
+            return rendering_enabled_;
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "create_trajectory_renderer",
+            [this](std::vector<std::string>& render_pass_names, int& width, int& height, float& fov, int& num_slots) -> std::map<std::string, ArrayDesc> {
+                SP_ASSERT(world_);
+                SP_ASSERT(!trajectory_renderer_);
+                SP_ASSERT(width > 0);
+                SP_ASSERT(height > 0);
+                trajectory_renderer_ = std::make_unique<TrajectoryRenderer>(world_, render_pass_names, width, height, fov, num_slots);
+                SP_ASSERT(trajectory_renderer_);
+                return trajectory_renderer_->getFrameSpace();
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "render_trajectory",
+            [this](std::vector<double>& poses, int& num_pose_components, int& num_warmup_frames, double& timeout) -> int {
+                SP_ASSERT(trajectory_renderer_);
+                return trajectory_renderer_->renderTrajectory(poses, num_pose_components, num_warmup_frames, timeout);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "create_dataset_writer",
+            [this](std::string& directory, std::map<std::string, std::string>& encodings) -> void {
+                SP_ASSERT(trajectory_renderer_);
+                trajectory_renderer_->createDatasetWriter(directory, encodings);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "flush_dataset_writer", [this]() -> void {
+            SP_ASSERT(trajectory_renderer_);
+            SP_ASSERT(trajectory_renderer_->getDatasetWriter());
+            trajectory_renderer_->getDatasetWriter()->flush();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_dataset_writer_stats", [this]() -> std::map<std::string, double> {
+            SP_ASSERT(trajectory_renderer_);
+            SP_ASSERT(trajectory_renderer_->getDatasetWriter());
+            return trajectory_renderer_->getDatasetWriter()->getStats();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "destroy_dataset_writer", [this]() -> void {
+            SP_ASSERT(trajectory_renderer_);
+            trajectory_renderer_->destroyDatasetWriter();
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "destroy_trajectory_renderer", [this]() -> void {
+            SP_ASSERT(trajectory_renderer_);
+            trajectory_renderer_ = nullptr;
         });
 
         unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_random_points", [this](int& num_points) -> std::vector<double> {
@@ -113,6 +335,43 @@ public:
             SP_ASSERT(nav_mesh_);
             return nav_mesh_->getPaths(initial_points, goal_points);
         });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_paths_packed",
+            [this](std::vector<double>& initial_points, std::vector<double>& goal_points) -> std::map<std::string, std::vector<uint8_t>> {
+                SP_ASSERT(nav_mesh_);
+                return nav_mesh_->getPathsPacked(initial_points, goal_points);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "sample_points",
+            [this](
+                int& num_points,
+                int& seed,
+                std::vector<double>& reference_point,
+                bool& reachable_from_reference_point,
+                double& min_distance_to_reference_point,
+                double& max_distance_to_reference_point,
+                double& min_separation) -> std::vector<uint8_t> {
+
+                SP_ASSERT(nav_mesh_);
+                return nav_mesh_->samplePoints(
+                    num_points, seed, reference_point, reachable_from_reference_point, min_distance_to_reference_point, max_distance_to_reference_point, min_separation);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "create_geodesic_distance_field", [this](std::vector<double>& goal_point) -> int {
+            SP_ASSERT(nav_mesh_);
+            return nav_mesh_->createGeodesicDistanceField(goal_point);
+        });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "get_geodesic_distances",
+            [this](int& geodesic_distance_field_id, std::vector<double>& points) -> std::vector<double> {
+                SP_ASSERT(nav_mesh_);
+                return nav_mesh_->getGeodesicDistances(geodesic_distance_field_id, points);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("legacy_service", "destroy_geodesic_distance_field", [this](int& geodesic_distance_field_id) -> void {
+            SP_ASSERT(nav_mesh_);
+            nav_mesh_->destroyGeodesicDistanceField(geodesic_distance_field_id);
+        });
     }
 
     ~LegacyService()
@@ -121,6 +380,19 @@ public:
         // We expect worldCleanUpEvenHandler(...) to be called before ~LegacyService().
         SP_ASSERT(!world_begin_play_handle_.IsValid());
 
+        if (action_log_reader_) {
+            stopReplay();
+        }
+
+        if (action_log_writer_) {
+            stopRecording();
+        }
+
+        if (preload_scene_handle_.IsValid()) {
+            preload_scene_handle_->ReleaseHandle();
+            preload_scene_handle_ = nullptr;
+        }
+
         FWorldDelegates::OnWorldCleanup.Remove(world_cleanup_handle_);
         FWorldDelegates::OnPostWorldInitialization.Remove(post_world_initialization_handle_);
 
@@ -133,6 +405,35 @@ public:
     void worldBeginPlayHandler();
 
 private:
+    // Rendering can be toggled between frames, e.g., to render an occasional frame for visualization in an otherwise
+    // physics-only simulation. Physics, ticking, and navigation are unaffected.
+    void setRenderingEnabled(bool enabled);
+
+    // helper functions for recording and replaying calls
+    void recordCall(ActionLogRecordType type, const std::map<std::string, std::vector<uint8_t>>& arrays = {});
+    void recordTick();
+    void startRecording(const std::string& file);
+    void stopRecording();
+    void recordingBeginFrameHandler();
+    void startReplay(const std::string& file, const std::string& observation_file);
+    void stopReplay();
+    void replayBeginFrameHandler();
+    void replayEndFrameHandler();
+    void replayRecords(ActionLogRecordPhase phase);
+
+    // helper functions for preloading and switching scenes
+    void preloadScene(const std::string& scene_id, const std::string& map_id);
+    void switchScene(const std::string& scene_id, const std::string& map_id);
+    static std::string getLevelName(const std::string& scene_id, const std::string& map_id);
+
+    // helper functions for the vectorized entry points
+    std::map<std::string, ArrayDesc> getVectorizedSpace(const std::map<std::string, ArrayDesc>& space) const;
+    void applyVectorizedAction(const std::map<std::string, std::vector<uint8_t>>& action);
+    std::map<std::string, std::vector<uint8_t>> getVectorizedObservation();
+    std::vector<uint8_t> autoResetVectorized();
+    void resetVectorized();
+    static std::map<std::string, std::vector<uint8_t>> stackArrays(const std::vector<std::map<std::string, std::vector<uint8_t>>>& arrays);
+
     FDelegateHandle post_world_initialization_handle_;
     FDelegateHandle world_begin_play_handle_;
     FDelegateHandle world_cleanup_handle_;
@@ -142,13 +443,40 @@ private:
     // Unreal life cycle state
     bool has_world_begin_play_executed_ = false;
     bool open_level_pending_ = false;
-
-    // OpenAI Gym helper objects
-    std::unique_ptr<Agent> agent_ = nullptr;
-    std::unique_ptr<Task> task_ = nullptr;
+    bool rendering_enabled_ = true;
+
+    // Scene switching state. If scene_id_override_ is non-empty, it takes precedence over SP_SERVICES.LEGACY_SERVICE.SCENE_ID
+    // and SP_SERVICES.LEGACY_SERVICE.MAP_ID, so we don't travel back to the configured scene after calling switch_scene.
+    std::string scene_id_override_;
+    std::string map_id_override_;
+    std::string preload_scene_level_name_; // most recently preloaded level, kept after its handle has been released
+    FStreamableManager streamable_manager_;
+    TSharedPtr<FStreamableHandle> preload_scene_handle_;
+
+    // OpenAI Gym helper objects, one Agent and one Task per agent index
+    std::vector<std::unique_ptr<Agent>> agents_;
+    std::vector<std::unique_ptr<Task>> tasks_;
+
+    // Recording and replay state
+    std::function<uint64_t()> get_frame_index_func_;
+    std::function<FrameState()> get_frame_state_func_;
+    std::unique_ptr<ActionLogWriter> action_log_writer_ = nullptr;
+    uint64_t recording_start_frame_index_ = 0;
+    uint64_t recording_num_frames_ = 0; // number of frames that have a Tick record
+    FDelegateHandle recording_begin_frame_handle_;
+    std::unique_ptr<ActionLogReader> action_log_reader_ = nullptr;
+    std::unique_ptr<ActionLogWriter> replay_observation_writer_ = nullptr;
+    uint64_t replay_frame_index_ = 0;
+    bool has_replay_begun_frame_ = false;
+    std::atomic<bool> is_replay_done_ = false;
+    FDelegateHandle replay_begin_frame_handle_;
+    FDelegateHandle replay_end_frame_handle_;
 
     // Navmesh helper object
     std::unique_ptr<NavMesh> nav_mesh_ = nullptr;
+
+    // Batch rendering helper object, only created on request
+    std::unique_ptr<TrajectoryRenderer> trajectory_renderer_ = nullptr;
 };
 
 //
@@ -165,13 +493,14 @@ template <> // needed to receive a custom type as an arg
 struct clmdep_msgpack::adaptor::convert<ArrayDesc> {
     clmdep_msgpack::object const& operator()(clmdep_msgpack::object const& object, ArrayDesc& array_desc) const {
         std::map<std::string, clmdep_msgpack::object> map = Msgpack::toMap(object);
-        SP_ASSERT(map.size() == 6);
+        SP_ASSERT(map.size() == 7);
         array_desc.low_ = Msgpack::to<double>(map.at("low_"));
         array_desc.high_ = Msgpack::to<double>(map.at("high_"));
         array_desc.shape_ = Msgpack::to<std::vector<int64_t>>(map.at("shape_"));
         array_desc.datatype_ = Msgpack::to<DataType>(map.at("datatype_"));
         array_desc.use_shared_memory_ = Msgpack::to<bool>(map.at("use_shared_memory_"));
         array_desc.shared_memory_name_ = Msgpack::to<std::string>(map.at("shared_memory_name_"));
+        array_desc.shared_memory_num_slots_ = Msgpack::to<int>(map.at("shared_memory_num_slots_"));
         return object;
     }
 };
@@ -185,7 +514,8 @@ struct clmdep_msgpack::adaptor::object_with_zone<ArrayDesc> {
             {"shape_", clmdep_msgpack::object(array_desc.shape_, object.zone)},
             {"datatype_", clmdep_msgpack::object(array_desc.datatype_, object.zone)},
             {"use_shared_memory_", clmdep_msgpack::object(array_desc.use_shared_memory_, object.zone)},
-            {"shared_memory_name_", clmdep_msgpack::object(array_desc.shared_memory_name_, object.zone)}};
+            {"shared_memory_name_", clmdep_msgpack::object(array_desc.shared_memory_name_, object.zone)},
+            {"shared_memory_num_slots_", clmdep_msgpack::object(array_desc.shared_memory_num_slots_, object.zone)}};
         Msgpack::toObject(object, map);
     }
 };
@@ -212,7 +212,7 @@ struct clmdep_msgpack::adaptor::convert<SpFuncSharedMemoryView> {
         std::map<std::string, clmdep_msgpack::object> map = Msgpack::toMap(object);
         SP_ASSERT(map.size() == 3);
         shared_memory_view.id_ = Msgpack::to<std::string>(map.at("id"));
-        shared_memory_view.num_bytes_ = Msgpack::to<int>(map.at("num_bytes"));
+        shared_memory_view.num_bytes_ = Msgpack::to<uint64_t>(map.at("num_bytes"));
         shared_memory_view.usage_flags_ = Msgpack::to<SpFuncSharedMemoryUsageFlags>(map.at("usage_flags"));
         return object;
     }
@@ -4,14 +4,22 @@
 
 #include "SpServices/UnrealService.h"
 
+#include <stdint.h> // uint64_t
+
 #include <string>
+#include <utility> // std::move
 #include <vector>
 
-#include <Engine/Engine.h> // GEngine
+#include <Containers/Array.h>
+#include <Engine/Engine.h>            // GEngine
+#include <Engine/StreamableManager.h> // FStreamableDelegate, FStreamableHandle
 #include <Engine/World.h>
+#include <UObject/SoftObjectPath.h>   // FSoftObjectPath
 
 #include "SpCore/Assert.h"
 #include "SpCore/Log.h"
+#include "SpCore/Std.h"
+#include "SpCore/Unreal.h"
 
 void UnrealService::postWorldInitializationHandler(UWorld* world, const UWorld::InitializationValues initialization_values)
 {
@@ -28,6 +36,28 @@ void UnrealService::worldCleanupHandler(UWorld* world, bool session_ended, bool
     SP_LOG_CURRENT_FUNCTION();
     SP_ASSERT(world);
     if (world == world_) {
+        world_snapshots_.clear();
         world_ = nullptr;
     }
 }
+
+uint64_t UnrealService::requestAsyncLoad(const std::vector<std::string>& paths, TAsyncLoadPriority priority)
+{
+    SP_ASSERT(!paths.empty());
+
+    AsyncLoadRequest async_load_request;
+    for (auto& path : paths) {
+        async_load_request.soft_object_paths_.Add(FSoftObjectPath(Unreal::toFString(path)));
+    }
+
+    // We pass bManageActiveHandle=true so the streamable manager keeps the requested objects alive until
+    // the handle is explicitly released via the release_async_load entry point.
+    bool manage_active_handle = true;
+    async_load_request.streamable_handle_ = streamable_manager_.RequestAsyncLoad(
+        async_load_request.soft_object_paths_, FStreamableDelegate(), priority, manage_active_handle);
+    SP_ASSERT(async_load_request.streamable_handle_.IsValid());
+
+    uint64_t handle = ++async_load_request_id_;
+    Std::insert(async_load_requests_, handle, std::move(async_load_request));
+    return handle;
+}
@@ -7,6 +7,7 @@
 #include <stdint.h> // uint64_t
 
 #include <map>
+#include <memory>      // std::make_unique, std::unique_ptr
 #include <string>
 #include <utility>     // std::make_pair, std::move
 #include <vector>
@@ -14,13 +15,16 @@
 #include <Components/ChildActorComponent.h>
 #include <Delegates/IDelegateInstance.h> // FDelegateHandle
 #include <Engine/Level.h>                // ULevel
+#include <Engine/StreamableManager.h>    // FStreamableHandle, FStreamableManager
 #include <Engine/World.h>                // FWorldDelegates, FActorSpawnParameters
 #include <HAL/IConsoleManager.h>
 #include <Kismet/GameplayStatics.h>
 #include <Misc/EnumClassFlags.h>         // ENUM_CLASS_FLAGS
+#include <Templates/SharedPointer.h>     // TSharedPtr
 #include <UObject/Class.h>               // EIncludeSuperFlag::Type
 #include <UObject/ObjectMacros.h>        // EObjectFlags, ELoadFlags
 #include <UObject/Package.h>
+#include <UObject/SoftObjectPath.h>      // FSoftObjectPath
 
 #include "SpCore/Assert.h"
 #include "SpCore/Log.h"
@@ -31,6 +35,7 @@
 #include "SpServices/EntryPointBinder.h"
 #include "SpServices/Msgpack.h"
 #include "SpServices/Rpclib.h"
+#include "SpServices/WorldSnapshot.h"
 
 #include "UnrealService.generated.h"
 
@@ -1035,6 +1040,85 @@ public:
                         toPtr<UPackageMap>(sandbox)));
             });
 
+        //
+        // Load objects asynchronously
+        //
+
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "load_objects_async",
+            [this](std::vector<std::string>& paths) -> uint64_t {
+                return requestAsyncLoad(paths, FStreamableManager::AsyncLoadHighPriority);
+            });
+
+        // Prefetching uses the same mechanism as load_objects_async, but at the default priority so prefetch
+        // requests don't delay more urgent requests that are already in flight.
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "prefetch_objects",
+            [this](std::vector<std::string>& paths) -> uint64_t {
+                return requestAsyncLoad(paths, FStreamableManager::DefaultAsyncLoadPriority);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "has_async_load_completed",
+            [this](uint64_t& handle) -> bool {
+                return async_load_requests_.at(handle).streamable_handle_->HasLoadCompleted();
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "get_async_load_progress",
+            [this](uint64_t& handle) -> float {
+                return async_load_requests_.at(handle).streamable_handle_->GetProgress();
+            });
+
+        // A timeout of 0.0 waits indefinitely. The returned vector contains one pointer per requested path,
+        // in the same order as the requested paths, and contains 0 for any path that could not be loaded.
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "wait_for_async_load",
+            [this](uint64_t& handle, float& timeout) -> std::vector<uint64_t> {
+                AsyncLoadRequest& async_load_request = async_load_requests_.at(handle);
+                async_load_request.streamable_handle_->WaitUntilComplete(timeout);
+                std::vector<uint64_t> objects;
+                for (auto& soft_object_path : async_load_request.soft_object_paths_) {
+                    objects.push_back(toUInt64(soft_object_path.ResolveObject()));
+                }
+                return objects;
+            });
+
+        // Releasing a handle allows the loaded objects to be garbage collected if nothing else references them.
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "release_async_load",
+            [this](uint64_t& handle) -> void {
+                async_load_requests_.at(handle).streamable_handle_->ReleaseHandle();
+                Std::remove(async_load_requests_, handle);
+            });
+
+        //
+        // Save and restore named world snapshots, see WorldSnapshot.h for details on what is recorded
+        //
+
+        // property_names are recorded for any actor whose class has a matching top-level property
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "save_world_snapshot",
+            [this](std::string& name, std::vector<std::string>& property_names) -> uint64_t {
+                SP_ASSERT(world_);
+                if (Std::containsKey(world_snapshots_, name)) {
+                    Std::remove(world_snapshots_, name);
+                }
+                std::unique_ptr<WorldSnapshot> world_snapshot = std::make_unique<WorldSnapshot>(world_, property_names);
+                uint64_t num_bytes = world_snapshot->getNumBytes();
+                Std::insert(world_snapshots_, name, std::move(world_snapshot));
+                return num_bytes;
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "restore_world_snapshot",
+            [this](std::string& name) -> void {
+                SP_ASSERT(world_);
+                world_snapshots_.at(name)->restore(world_);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "remove_world_snapshot",
+            [this](std::string& name) -> void {
+                Std::remove(world_snapshots_, name);
+            });
+
+        unreal_entry_point_binder->bindFuncUnreal("unreal_service", "get_world_snapshot_names",
+            [this]() -> std::vector<std::string> {
+                return Std::keys(world_snapshots_);
+            });
+
         //
         // Find, get, and set console variables
         //
@@ -1121,6 +1205,11 @@ public:
 
     ~UnrealService()
     {
+        for (auto& [handle, async_load_request] : async_load_requests_) {
+            async_load_request.streamable_handle_->ReleaseHandle();
+        }
+        async_load_requests_.clear();
+
         FWorldDelegates::OnWorldCleanup.Remove(world_cleanup_handle_);
         FWorldDelegates::OnPostWorldInitialization.Remove(post_world_initialization_handle_);
 
@@ -1133,6 +1222,14 @@ public:
 
 private:
 
+    struct AsyncLoadRequest
+    {
+        TArray<FSoftObjectPath> soft_object_paths_;
+        TSharedPtr<FStreamableHandle> streamable_handle_;
+    };
+
+    uint64_t requestAsyncLoad(const std::vector<std::string>& paths, TAsyncLoadPriority priority);
+
     template <typename TValue>
     static uint64_t toUInt64(const TValue* src)
     {
@@ -1161,6 +1258,13 @@ private:
     FDelegateHandle world_cleanup_handle_;
 
     UWorld* world_ = nullptr;
+
+    FStreamableManager streamable_manager_;
+    std::map<uint64_t, AsyncLoadRequest> async_load_requests_;
+    uint64_t async_load_request_id_ = 0;
+
+    // snapshots refer to actors in world_, so they are discarded when world_ is cleaned up
+    std::map<std::string, std::unique_ptr<WorldSnapshot>> world_snapshots_;
 };
 
 //
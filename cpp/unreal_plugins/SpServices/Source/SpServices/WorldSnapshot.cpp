@@ -0,0 +1,177 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#include "SpServices/WorldSnapshot.h"
+
+#include <stdint.h> // uint8_t, uint64_t
+#include <string.h> // memcpy
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Components/ActorComponent.h>
+#include <Components/PrimitiveComponent.h>
+#include <Engine/EngineTypes.h>  // ETeleportType
+#include <Engine/World.h>        // FActorSpawnParameters
+#include <GameFramework/Actor.h>
+#include <Math/Transform.h>
+#include <UObject/Class.h>
+#include <UObject/NameTypes.h>   // FName
+#include <UObject/UnrealType.h>  // CPF_IsPlainOldData, FProperty
+
+#include "SpCore/Assert.h"
+#include "SpCore/Log.h"
+#include "SpCore/Std.h"
+#include "SpCore/Unreal.h"
+
+WorldSnapshot::WorldSnapshot(UWorld* world, const std::vector<std::string>& property_names)
+{
+    SP_ASSERT(world);
+
+    for (auto actor : Unreal::findActors(world)) {
+        SP_ASSERT(actor);
+
+        ActorState actor_state;
+        actor_state.actor_ = actor;
+        actor_state.class_ = actor->GetClass();
+        actor_state.name_ = actor->GetFName();
+        actor_state.transform_ = actor->GetActorTransform();
+
+        actor_state.first_component_state_index_ = component_states_.size();
+        for (auto primitive_component : Unreal::getComponentsByType<UPrimitiveComponent>(actor)) {
+            if (primitive_component->IsSimulatingPhysics()) {
+                ComponentState component_state;
+                component_state.component_ = primitive_component;
+                component_state.name_ = primitive_component->GetFName();
+                component_state.transform_ = primitive_component->GetComponentTransform();
+                component_state.linear_velocity_ = primitive_component->GetPhysicsLinearVelocity();
+                component_state.angular_velocity_ = primitive_component->GetPhysicsAngularVelocityInDegrees();
+                component_states_.push_back(component_state);
+            }
+        }
+        actor_state.num_component_states_ = component_states_.size() - actor_state.first_component_state_index_;
+
+        // Unreal::findPropertyByName(...) asserts if a property can't be found, so we only record properties whose
+        // top-level name is present on the actor's class.
+        actor_state.first_property_state_index_ = property_states_.size();
+        for (auto& property_name : property_names) {
+            std::vector<std::string> property_name_tokens = Std::tokenize(property_name, ".[");
+            SP_ASSERT(!property_name_tokens.empty());
+            if (!actor->GetClass()->FindPropertyByName(Unreal::toFName(property_name_tokens.at(0)))) {
+                continue;
+            }
+
+            Unreal::PropertyDesc property_desc = Unreal::findPropertyByName(actor, property_name);
+            PropertyState property_state;
+            property_state.name_ = property_name;
+            property_state.is_plain_old_data_ = property_desc.property_->HasAnyPropertyFlags(CPF_IsPlainOldData);
+            if (property_state.is_plain_old_data_) {
+                property_state.offset_ = property_data_.size();
+                property_state.num_bytes_ = property_desc.property_->GetSize();
+                property_data_.resize(property_data_.size() + property_state.num_bytes_);
+                memcpy(property_data_.data() + property_state.offset_, property_desc.value_ptr_, property_state.num_bytes_);
+            } else {
+                property_state.string_ = Unreal::getPropertyValueAsString(property_desc);
+            }
+            property_states_.push_back(property_state);
+        }
+        actor_state.num_property_states_ = property_states_.size() - actor_state.first_property_state_index_;
+
+        actor_states_.push_back(actor_state);
+    }
+}
+
+void WorldSnapshot::restore(UWorld* world)
+{
+    SP_ASSERT(world);
+
+    // destroy actors that were spawned after the snapshot was taken
+    std::set<AActor*> snapshot_actors;
+    for (auto& actor_state : actor_states_) {
+        if (actor_state.actor_.IsValid()) {
+            snapshot_actors.insert(actor_state.actor_.Get());
+        }
+    }
+    for (auto actor : Unreal::findActors(world)) {
+        if (!snapshot_actors.contains(actor)) {
+            world->DestroyActor(actor);
+        }
+    }
+
+    for (auto& actor_state : actor_states_) {
+
+        // respawn actors that were destroyed after the snapshot was taken
+        if (!actor_state.actor_.IsValid()) {
+            if (!actor_state.class_.IsValid()) {
+                SP_LOG("WARNING: Can't respawn actor because its class is no longer loaded: ", Unreal::toStdString(actor_state.name_));
+                continue;
+            }
+            SP_LOG("Respawning actor: ", Unreal::toStdString(actor_state.name_));
+            FActorSpawnParameters actor_spawn_parameters;
+            actor_spawn_parameters.Name = actor_state.name_;
+            actor_spawn_parameters.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+            actor_spawn_parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+            actor_state.actor_ = world->SpawnActor(actor_state.class_.Get(), &actor_state.transform_, actor_spawn_parameters);
+            SP_ASSERT(actor_state.actor_.IsValid());
+        }
+
+        AActor* actor = actor_state.actor_.Get();
+        actor->SetActorTransform(actor_state.transform_, false, nullptr, ETeleportType::ResetPhysics);
+
+        for (uint64_t i = 0; i < actor_state.num_property_states_; i++) {
+            PropertyState& property_state = property_states_.at(actor_state.first_property_state_index_ + i);
+            Unreal::PropertyDesc property_desc = Unreal::findPropertyByName(actor, property_state.name_);
+            if (property_state.is_plain_old_data_) {
+                SP_ASSERT(property_desc.property_->GetSize() == property_state.num_bytes_);
+                memcpy(property_desc.value_ptr_, property_data_.data() + property_state.offset_, property_state.num_bytes_);
+            } else {
+                Unreal::setPropertyValueFromString(property_desc, property_state.string_);
+            }
+        }
+
+        // restore physics state after setting the actor transform, because ETeleportType::ResetPhysics clears velocities
+        for (uint64_t i = 0; i < actor_state.num_component_states_; i++) {
+            ComponentState& component_state = component_states_.at(actor_state.first_component_state_index_ + i);
+            if (!component_state.component_.IsValid()) {
+                component_state.component_ = findPrimitiveComponentByName(actor, component_state.name_);
+                if (!component_state.component_.IsValid()) {
+                    continue;
+                }
+            }
+            UPrimitiveComponent* primitive_component = component_state.component_.Get();
+            primitive_component->SetWorldTransform(component_state.transform_, false, nullptr, ETeleportType::ResetPhysics);
+            primitive_component->SetPhysicsLinearVelocity(component_state.linear_velocity_);
+            primitive_component->SetPhysicsAngularVelocityInDegrees(component_state.angular_velocity_);
+        }
+    }
+}
+
+uint64_t WorldSnapshot::getNumActors() const
+{
+    return actor_states_.size();
+}
+
+uint64_t WorldSnapshot::getNumBytes() const
+{
+    uint64_t num_bytes =
+        actor_states_.size()*sizeof(ActorState) +
+        component_states_.size()*sizeof(ComponentState) +
+        property_states_.size()*sizeof(PropertyState) +
+        property_data_.size();
+    for (auto& property_state : property_states_) {
+        num_bytes += property_state.name_.size() + property_state.string_.size();
+    }
+    return num_bytes;
+}
+
+UPrimitiveComponent* WorldSnapshot::findPrimitiveComponentByName(const AActor* actor, const FName& name)
+{
+    for (auto primitive_component : Unreal::getComponentsByType<UPrimitiveComponent>(actor)) {
+        if (primitive_component->GetFName() == name) {
+            return primitive_component;
+        }
+    }
+    return nullptr;
+}
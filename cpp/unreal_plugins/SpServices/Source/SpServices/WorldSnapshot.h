@@ -0,0 +1,84 @@
+//
+// Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+
+#pragma once
+
+#include <stdint.h> // uint8_t, uint64_t
+
+#include <string>
+#include <vector>
+
+#include <Math/Transform.h>
+#include <Math/Vector.h>
+#include <UObject/NameTypes.h> // FName
+#include <UObject/WeakObjectPtrTemplates.h>
+
+class AActor;
+class UClass;
+class UPrimitiveComponent;
+class UWorld;
+
+//
+// A WorldSnapshot records the state of every actor in a world, so the world can be returned to that state in a
+// single pass without reloading the level. For each actor, we record its class, name, and transform. For each
+// primitive component that is simulating physics, we record its world transform, and its linear and angular
+// velocities. For each actor that has a top-level property named in property_names, we record the property's
+// value. Plain-old-data property values are copied into a single contiguous buffer, and other property values
+// are stored as strings.
+//
+// When a snapshot is restored, actors that were spawned after the snapshot was taken are destroyed, and actors
+// that were destroyed after the snapshot was taken are spawned again with the same class, name, and transform.
+// Respawned actors are constructed from their class defaults, so any state that isn't recorded in the snapshot
+// will differ from the original actor. If an actor's class has been unloaded, the actor is skipped.
+//
+
+class WorldSnapshot
+{
+public:
+    WorldSnapshot() = delete;
+    WorldSnapshot(UWorld* world, const std::vector<std::string>& property_names);
+
+    void restore(UWorld* world);
+
+    uint64_t getNumActors() const;
+    uint64_t getNumBytes() const;
+
+private:
+    struct ActorState
+    {
+        TWeakObjectPtr<AActor> actor_;
+        TWeakObjectPtr<UClass> class_; // weak because the class can be garbage collected, e.g., if it was a Blueprint class
+        FName name_;
+        FTransform transform_;
+        uint64_t first_component_state_index_ = 0;
+        uint64_t num_component_states_ = 0;
+        uint64_t first_property_state_index_ = 0;
+        uint64_t num_property_states_ = 0;
+    };
+
+    struct ComponentState
+    {
+        TWeakObjectPtr<UPrimitiveComponent> component_;
+        FName name_;
+        FTransform transform_;
+        FVector linear_velocity_;
+        FVector angular_velocity_; // degrees per second
+    };
+
+    struct PropertyState
+    {
+        std::string name_;
+        bool is_plain_old_data_ = false;
+        uint64_t offset_ = 0;    // offset into property_data_ if is_plain_old_data_ is true
+        uint64_t num_bytes_ = 0; // number of bytes in property_data_ if is_plain_old_data_ is true
+        std::string string_;     // property value as a string if is_plain_old_data_ is false
+    };
+
+    static UPrimitiveComponent* findPrimitiveComponentByName(const AActor* actor, const FName& name);
+
+    std::vector<ActorState> actor_states_;
+    std::vector<ComponentState> component_states_;
+    std::vector<PropertyState> property_states_;
+    std::vector<uint8_t> property_data_;
+};
@@ -11,7 +11,10 @@
 #include <vector>
 
 #include <Containers/Array.h>
-#include <Engine/EngineBaseTypes.h> // ETickingGroup
+#include <Engine/EngineBaseTypes.h>   // ETickingGroup
+#include <Engine/StreamableManager.h> // FStreamableHandle, FStreamableManager
+#include <Templates/SharedPointer.h>  // TSharedPtr
+#include <UObject/SoftObjectPath.h>   // FSoftObjectPath
 
 #include "SpCore/ArrayDesc.h" // TODO: remove
 #include "SpCore/Assert.h"
@@ -192,6 +195,21 @@ void UUrdfRobotComponent::initialize(const UrdfRobotDesc* robot_desc)
 
     SP_ASSERT(robot_desc);
 
+    // Loading each static mesh and material synchronously while we construct the component hierarchy can be
+    // very slow for robots with many visual meshes, because each cold load blocks before the next one can be
+    // issued. So we optionally gather all asset paths up front and request them together, which allows the
+    // async loading thread to process them in parallel. The subsequent LoadObject calls in UUrdfLinkComponent
+    // will then find the assets already in memory.
+    FStreamableManager streamable_manager;
+    TSharedPtr<FStreamableHandle> streamable_handle;
+    if (Config::isInitialized() && Config::get<bool>("URDF_ROBOT.URDF_ROBOT_COMPONENT.PREFETCH_ASSETS")) {
+        TArray<FSoftObjectPath> soft_object_paths;
+        for (auto& asset_path : getAssetPaths(robot_desc)) {
+            soft_object_paths.Add(FSoftObjectPath(Unreal::toFString(asset_path)));
+        }
+        streamable_handle = streamable_manager.RequestSyncLoad(soft_object_paths);
+    }
+
     UrdfLinkDesc* root_link_desc = robot_desc->root_link_desc_;
     SP_ASSERT(root_link_desc);
 
@@ -205,6 +223,10 @@ void UUrdfRobotComponent::initialize(const UrdfRobotDesc* robot_desc)
     LinkComponents.Add(RootLinkComponent);
 
     initialize(root_link_desc, RootLinkComponent);
+
+    if (streamable_handle.IsValid()) {
+        streamable_handle->ReleaseHandle();
+    }
 }
 
 void UUrdfRobotComponent::initialize(const UrdfLinkDesc* parent_link_desc, UUrdfLinkComponent* parent_link_component)
@@ -246,6 +268,51 @@ void UUrdfRobotComponent::initialize(const UrdfLinkDesc* parent_link_desc, UUrdf
     request_initialize_deferred_ = true;
 }
 
+std::vector<std::string> UUrdfRobotComponent::getAssetPaths(const UrdfRobotDesc* robot_desc)
+{
+    SP_ASSERT(robot_desc);
+
+    // These paths need to match the paths used in UUrdfLinkComponent::initialize(...)
+    std::vector<std::string> asset_paths = {
+        "/UrdfRobot/Common/Meshes/SM_Dummy.SM_Dummy",
+        "/UrdfRobot/Common/Materials/M_PureColor.M_PureColor"};
+
+    for (auto& [link_name, link_desc] : robot_desc->link_descs_) {
+        for (auto& visual_desc : link_desc.visual_descs_) {
+            const UrdfGeometryDesc& geometry_desc = visual_desc.geometry_desc_;
+            switch (geometry_desc.type_) {
+                case UrdfGeometryType::Box:
+                    asset_paths.push_back("/Engine/BasicShapes/Cube.Cube");
+                    break;
+                case UrdfGeometryType::Cylinder:
+                    asset_paths.push_back("/Engine/BasicShapes/Cylinder.Cylinder");
+                    break;
+                case UrdfGeometryType::Sphere:
+                    asset_paths.push_back("/Engine/BasicShapes/Sphere.Sphere");
+                    break;
+                case UrdfGeometryType::Mesh:
+                    asset_paths.push_back(geometry_desc.unreal_static_mesh_);
+                    break;
+                default:
+                    SP_ASSERT(false);
+            }
+
+            if (visual_desc.has_material_) {
+                const UrdfMaterialDesc* material_desc = &(visual_desc.material_desc_);
+                if (material_desc->is_reference_) {
+                    material_desc = material_desc->material_desc_;
+                }
+                SP_ASSERT(material_desc);
+                if (material_desc->unreal_material_ != "") {
+                    asset_paths.push_back(material_desc->unreal_material_);
+                }
+            }
+        }
+    }
+
+    return Std::unique(asset_paths);
+}
+
 void UUrdfRobotComponent::initializeDeferred()
 {
     // Cache components in maps so we can refer to them by name. We need to do this in BeginPlay() because after pressing play
@@ -70,6 +70,9 @@ private:
     void initialize(const UrdfLinkDesc* parent_link_desc, UUrdfLinkComponent* parent_link_component);
     void initializeDeferred();
 
+    // Returns the paths of all static meshes and materials that will be loaded when initializing robot_desc.
+    static std::vector<std::string> getAssetPaths(const UrdfRobotDesc* robot_desc);
+
     void applyAction(const std::map<std::string, std::vector<double>>& action);
 
     std::vector<std::string> action_components_;
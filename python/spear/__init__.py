@@ -9,7 +9,7 @@ import sys
 from yacs.config import CfgNode
 
 from spear.engine_service import EngineService
-from spear.env import Env
+from spear.env import Env, VectorEnv
 from spear.instance import Instance
 from spear.legacy_service import LegacyService
 from spear.log import log, log_current_function, log_no_prefix, log_get_prefix
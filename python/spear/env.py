@@ -8,6 +8,7 @@ import mmap
 import multiprocessing.shared_memory
 import numpy as np
 import sys
+import time
 
 
 class Env(gym.Env):
@@ -125,7 +126,7 @@ class Env(gym.Env):
 
     def _get_observation(self):
 
-        observation_shared = self._observation_space_desc.shared_memory_arrays
+        observation_shared = self._observation_space_desc.get_shared_memory_arrays()
 
         observation_non_shared_serialized = self._instance.legacy_service.get_observation()
         observation_non_shared = _deserialize_arrays(
@@ -171,6 +172,101 @@ class Env(gym.Env):
         return self._instance.legacy_service.is_task_ready() and self._instance.legacy_service.is_agent_ready()
 
 
+# Steps every agent in a world created with SP_SERVICES.LEGACY_SERVICE.NUM_AGENTS greater than 1. Actions and observations
+# are dicts of arrays with shape [num_agents, ...], and step(...) returns arrays of rewards and done flags. Agents whose
+# episode is done are reset automatically at the end of step(...), so the observation returned for these agents is the
+# final observation of the previous episode.
+class VectorEnv():
+    def __init__(self, instance, config):
+
+        self._instance = instance
+        self._config = config
+
+        self._byte_order = self._instance.engine_service.get_byte_order()
+
+        self.num_agents = self._instance.legacy_service.get_num_agents()
+
+        self._action_space_desc = SpaceDesc(
+            self._instance.legacy_service.get_vectorized_action_space(), dict_space_type=gym.spaces.Dict, box_space_type=gym.spaces.Box)
+        self._observation_space_desc = SpaceDesc(
+            self._instance.legacy_service.get_vectorized_observation_space(), dict_space_type=gym.spaces.Dict, box_space_type=gym.spaces.Box)
+        self._task_step_info_space_desc = SpaceDesc(
+            self._instance.legacy_service.get_vectorized_task_step_info_space(), dict_space_type=Dict, box_space_type=Box)
+        self._agent_step_info_space_desc = SpaceDesc(
+            self._instance.legacy_service.get_vectorized_agent_step_info_space(), dict_space_type=Dict, box_space_type=Box)
+
+        # vectorized spaces never use shared memory
+        assert len(self._action_space_desc.array_descs_shared) == 0
+        assert len(self._observation_space_desc.array_descs_shared) == 0
+
+        self._instance.engine_service.begin_tick()
+
+        gameplay_statics_class = self._instance.unreal_service.get_static_class(class_name="UGameplayStatics")
+        self._gameplay_statics_default_object = self._instance.unreal_service.get_default_object(uclass=gameplay_statics_class, create_if_needed=False)
+        self._set_game_paused_func = self._instance.unreal_service.find_function_by_name(uclass=gameplay_statics_class, name="SetGamePaused")
+
+        self._instance.engine_service.tick()
+        self._instance.engine_service.end_tick()
+
+        self.action_space = self._action_space_desc.space
+        self.observation_space = self._observation_space_desc.space
+
+    def step(self, action):
+
+        assert action.keys() == self._action_space_desc.space.spaces.keys()
+
+        self.begin_tick()
+        self._instance.legacy_service.apply_vectorized_action(
+            _serialize_arrays(action, space=self._action_space_desc.space, byte_order=self._byte_order))
+        self.tick()
+        obs = _deserialize_arrays(
+            self._instance.legacy_service.get_vectorized_observation(), space=self._observation_space_desc.space, byte_order=self._byte_order)
+        rewards = self._instance.legacy_service.get_vectorized_rewards()
+        step_info = {
+            "task_step_info": _deserialize_arrays(
+                self._instance.legacy_service.get_vectorized_task_step_info(), space=self._task_step_info_space_desc.space, byte_order=self._byte_order),
+            "agent_step_info": _deserialize_arrays(
+                self._instance.legacy_service.get_vectorized_agent_step_info(), space=self._agent_step_info_space_desc.space, byte_order=self._byte_order)}
+        is_done = self._instance.legacy_service.auto_reset_vectorized()
+        self.end_tick()
+
+        return obs, rewards, is_done, step_info
+
+    def reset(self):
+
+        for i in range(self._config.SPEAR.ENV.MAX_NUM_FRAMES_AFTER_RESET):
+            self.begin_tick()
+            if i == 0:
+                self._instance.legacy_service.reset_vectorized() # only reset the simulation once
+            self.tick()
+            ready = self._instance.legacy_service.is_vectorized_ready()
+            if ready or i == self._config.SPEAR.ENV.MAX_NUM_FRAMES_AFTER_RESET - 1:
+                obs = _deserialize_arrays(
+                    self._instance.legacy_service.get_vectorized_observation(), space=self._observation_space_desc.space, byte_order=self._byte_order)
+            self.end_tick()
+            if ready:
+                break
+
+        return obs
+
+    def close(self):
+        self._action_space_desc.terminate()
+        self._observation_space_desc.terminate()
+        self._task_step_info_space_desc.terminate()
+        self._agent_step_info_space_desc.terminate()
+
+    def begin_tick(self):
+        self._instance.engine_service.begin_tick()
+        self._instance.unreal_service.call_function(uobject=self._gameplay_statics_default_object, ufunction=self._set_game_paused_func, args={"bPaused": False})
+
+    def tick(self):
+        self._instance.engine_service.tick()
+
+    def end_tick(self):
+        self._instance.unreal_service.call_function(uobject=self._gameplay_statics_default_object, ufunction=self._set_game_paused_func, args={"bPaused": True})
+        self._instance.engine_service.end_tick()
+
+
 # metadata for describing a space including the shared memory objects
 class SpaceDesc():
     def __init__(self, array_descs, dict_space_type, box_space_type):
@@ -188,21 +284,55 @@ class SpaceDesc():
         # shared memory
         self.shared_memory_objects = {}
         self.shared_memory_arrays = {}
+        self.shared_memory_triple_buffer_headers = {}
+        self.shared_memory_triple_buffer_slot_arrays = {}
         for name, array_desc in self.array_descs_shared.items():
+            shape = tuple(array_desc["shape_"])
+            dtype = DATATYPE_TO_DTYPE[array_desc["datatype_"]]
+            num_bytes = np.prod(array_desc["shape_"]) * dtype.itemsize
+            num_slots = array_desc["shared_memory_num_slots_"]
+            if num_slots > 1:
+                assert num_slots == TRIPLE_BUFFER_NUM_SLOTS
+                num_bytes = _get_triple_buffer_num_bytes(num_bytes)
+
             if sys.platform == "win32":
-                self.shared_memory_objects[name] = mmap.mmap(
-                    -1, np.prod(array_desc["shape_"]) * DATATYPE_TO_DTYPE[array_desc["datatype_"]].itemsize, array_desc["shared_memory_name_"])
-                self.shared_memory_arrays[name] = np.ndarray(
-                    shape=tuple(array_desc["shape_"]), dtype=DATATYPE_TO_DTYPE[array_desc["datatype_"]], buffer=self.shared_memory_objects[name])
+                self.shared_memory_objects[name] = mmap.mmap(-1, num_bytes, array_desc["shared_memory_name_"])
+                buffer = self.shared_memory_objects[name]
             elif sys.platform in ["darwin", "linux"]:
                 self.shared_memory_objects[name] = multiprocessing.shared_memory.SharedMemory(name=array_desc["shared_memory_name_"])
-                self.shared_memory_arrays[name] = np.ndarray(
-                    shape=tuple(array_desc["shape_"]), dtype=DATATYPE_TO_DTYPE[array_desc["datatype_"]], buffer=self.shared_memory_objects[name].buf)
+                buffer = self.shared_memory_objects[name].buf
             else:
                 assert False
 
+            if num_slots > 1:
+                header = np.ndarray(shape=(), dtype=TRIPLE_BUFFER_HEADER_DTYPE, buffer=buffer)
+                assert header["num_slots"] == num_slots
+                self.shared_memory_triple_buffer_headers[name] = header
+                self.shared_memory_triple_buffer_slot_arrays[name] = [
+                    np.ndarray(shape=shape, dtype=dtype, buffer=buffer, offset=int(header["slot_offset"] + i*header["slot_stride"])) for i in range(num_slots) ]
+                self.shared_memory_arrays[name] = self.shared_memory_triple_buffer_slot_arrays[name][int(header["latest_slot"])]
+            else:
+                self.shared_memory_arrays[name] = np.ndarray(shape=shape, dtype=dtype, buffer=buffer)
+
+    # For triple-buffered arrays, claim the most recently published slot, so the producer won't overwrite it while
+    # we're reading it. The returned arrays remain valid until the next call to this function.
+    def get_shared_memory_arrays(self):
+        for name, header in self.shared_memory_triple_buffer_headers.items():
+            while True:
+                sequence = int(header["sequence"])
+                if sequence % 2 != 0:
+                    continue
+                latest_slot = int(header["latest_slot"])
+                header["reader_slot"] = latest_slot
+                if int(header["sequence"]) == sequence:
+                    break
+            self.shared_memory_arrays[name] = self.shared_memory_triple_buffer_slot_arrays[name][latest_slot]
+        return self.shared_memory_arrays
+
     def terminate(self):
         self.shared_memory_arrays = {}
+        self.shared_memory_triple_buffer_headers = {}
+        self.shared_memory_triple_buffer_slot_arrays = {}
         for name, shared_memory_object in self.shared_memory_objects.items():
             if sys.platform == "win32":
                 shared_memory_object.close()
@@ -223,6 +353,65 @@ class SpaceDesc():
             self.shared_memory_arrays[name][:] = data[name][:]
 
 
+# Reads the frames streamed by legacy_service.render_trajectory(...) from the shared memory ring created by
+# legacy_service.create_trajectory_renderer(...). Frames should be read from a separate thread while
+# render_trajectory(...) is executing, because the ring only has room for a limited number of frames.
+class TrajectoryFrameRing():
+    def __init__(self, array_descs):
+        self._names = sorted(array_descs.keys())
+        assert len(self._names) > 0
+        shared_memory_name = array_descs[self._names[0]]["shared_memory_name_"]
+        num_slots = array_descs[self._names[0]]["shared_memory_num_slots_"]
+
+        # the slot layout must match TrajectoryRenderer.cpp
+        offsets = {}
+        slot_num_bytes = TRAJECTORY_FRAME_HEADER_NUM_BYTES
+        for name in self._names:
+            offsets[name] = slot_num_bytes
+            dtype = DATATYPE_TO_DTYPE[array_descs[name]["datatype_"]]
+            slot_num_bytes += _align(int(np.prod(array_descs[name]["shape_"])) * dtype.itemsize, FRAME_RING_ALIGNMENT)
+        num_bytes = _align(FRAME_RING_HEADER_DTYPE.itemsize, FRAME_RING_ALIGNMENT) + num_slots * _align(slot_num_bytes, FRAME_RING_ALIGNMENT)
+
+        if sys.platform == "win32":
+            self._shared_memory_object = mmap.mmap(-1, num_bytes, shared_memory_name)
+            buffer = self._shared_memory_object
+        elif sys.platform in ["darwin", "linux"]:
+            self._shared_memory_object = multiprocessing.shared_memory.SharedMemory(name=shared_memory_name)
+            buffer = self._shared_memory_object.buf
+        else:
+            assert False
+
+        self._header = np.ndarray(shape=(), dtype=FRAME_RING_HEADER_DTYPE, buffer=buffer)
+        assert self._header["num_slots"] == num_slots
+
+        self._slot_pose_indices = []
+        self._slot_arrays = []
+        for i in range(num_slots):
+            slot_offset = int(self._header["slot_offset"] + i*self._header["slot_stride"])
+            self._slot_pose_indices.append(np.ndarray(shape=(), dtype=np.uint64, buffer=buffer, offset=slot_offset))
+            self._slot_arrays.append({ name: np.ndarray(
+                shape=tuple(array_descs[name]["shape_"]), dtype=DATATYPE_TO_DTYPE[array_descs[name]["datatype_"]], buffer=buffer, offset=slot_offset + offsets[name])
+                for name in self._names })
+
+    # Yields (pose_index, arrays) for the next num_frames frames. The arrays are views into shared memory, and the
+    # slot is released when the generator advances, so the arrays must be copied if they are needed for longer.
+    def read_frames(self, num_frames):
+        num_slots = int(self._header["num_slots"])
+        for _ in range(num_frames):
+            read_index = int(self._header["read_index"])
+            while int(self._header["write_index"]) <= read_index:
+                time.sleep(0)
+            slot = read_index % num_slots
+            yield int(self._slot_pose_indices[slot]), self._slot_arrays[slot]
+            self._header["read_index"] = read_index + 1
+
+    def close(self):
+        self._header = None
+        self._slot_pose_indices = []
+        self._slot_arrays = []
+        self._shared_memory_object.close() # the C++ TrajectoryRenderer unlinks the shared memory object
+
+
 # mimics the behavior of gym.spaces.Box but allows shape to have the entry -1
 class Box():
     def __init__(self, low, high, shape, dtype):
@@ -263,6 +452,40 @@ DATATYPE_TO_DTYPE = {
     DataType.Float64.value:    np.dtype("f8")}
 
 
+# must be kept in sync with cpp/unreal_plugins/SpCore/Source/SpCore/SharedMemoryTripleBuffer.h
+TRIPLE_BUFFER_NUM_SLOTS = 3
+TRIPLE_BUFFER_ALIGNMENT = 64
+TRIPLE_BUFFER_HEADER_DTYPE = np.dtype([
+    ("sequence", np.uint64),
+    ("frame_index", np.uint64),
+    ("latest_slot", np.uint32),
+    ("reader_slot", np.uint32),
+    ("writer_slot", np.uint32),
+    ("num_slots", np.uint32),
+    ("slot_offset", np.uint64),
+    ("slot_stride", np.uint64)])
+
+# must be kept in sync with cpp/unreal_plugins/SpCore/Source/SpCore/SharedMemoryFrameRing.h
+FRAME_RING_ALIGNMENT = 64
+FRAME_RING_HEADER_DTYPE = np.dtype([
+    ("write_index", np.uint64),
+    ("read_index", np.uint64),
+    ("num_slots", np.uint64),
+    ("slot_offset", np.uint64),
+    ("slot_stride", np.uint64)])
+
+# must be kept in sync with cpp/unreal_plugins/SpServices/Source/SpServices/Legacy/TrajectoryRenderer.cpp
+TRAJECTORY_FRAME_HEADER_NUM_BYTES = 64
+
+def _align(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+def _get_triple_buffer_num_bytes(slot_num_bytes):
+    slot_offset = _align(TRIPLE_BUFFER_HEADER_DTYPE.itemsize, TRIPLE_BUFFER_ALIGNMENT)
+    slot_stride = _align(slot_num_bytes, TRIPLE_BUFFER_ALIGNMENT)
+    return slot_offset + TRIPLE_BUFFER_NUM_SLOTS * slot_stride
+
+
 # functions for creating Python spaces from C++ array_descs
 def _create_dict_space(array_descs, dict_space_type, box_space_type):
     return dict_space_type({ name: _create_box_space(array_desc, box_space_type=box_space_type) for name, array_desc in array_descs.items() })
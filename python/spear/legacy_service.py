@@ -8,6 +8,73 @@ class LegacyService():
     def __init__(self, rpc_client):
         self._rpc_client = rpc_client
 
+    # records calls to the stepping and reset entry points into a binary action log
+    def start_recording(self, file):
+        self._rpc_client.call("legacy_service.start_recording", file)
+
+    def stop_recording(self):
+        self._rpc_client.call("legacy_service.stop_recording")
+
+    # replays an action log inside the engine, stop calling begin_tick() after calling start_replay(...) and poll is_replay_done(),
+    # if observation_file is non-empty, observations are captured during replay and written to observation_file as an action log
+    def start_replay(self, file, observation_file=""):
+        self._rpc_client.call("legacy_service.start_replay", file, observation_file)
+
+    def stop_replay(self):
+        self._rpc_client.call("legacy_service.stop_replay")
+
+    def is_replay_done(self):
+        return self._rpc_client.call("legacy_service.is_replay_done")
+
+    # streams a scene in the background while the current episode continues, an empty map_id refers to the map with the same name as the scene
+    def preload_scene(self, scene_id, map_id=""):
+        self._rpc_client.call("legacy_service.preload_scene", scene_id, map_id)
+
+    def get_preload_scene_progress(self):
+        return self._rpc_client.call("legacy_service.get_preload_scene_progress")
+
+    def has_preload_scene_completed(self):
+        return self._rpc_client.call("legacy_service.has_preload_scene_completed")
+
+    # travels to a scene, which is much faster if the scene has been preloaded, the new world is ready once the instance has ticked
+    def switch_scene(self, scene_id, map_id=""):
+        self._rpc_client.call("legacy_service.switch_scene", scene_id, map_id)
+
+    # call between begin_tick() and tick() to control whether or not the current frame is rendered, physics runs either way
+    def set_rendering_enabled(self, enabled):
+        self._rpc_client.call("legacy_service.set_rendering_enabled", enabled)
+
+    def is_rendering_enabled(self):
+        return self._rpc_client.call("legacy_service.is_rendering_enabled")
+
+    # returns array descs for the frames that render_trajectory(...) writes into shared memory, read them with spear.env.TrajectoryFrameRing
+    def create_trajectory_renderer(self, render_pass_names, width, height, fov, num_slots):
+        return self._rpc_client.call("legacy_service.create_trajectory_renderer", render_pass_names, width, height, fov, num_slots)
+
+    # poses has shape [N, 6] for (x, y, z, pitch, yaw, roll) or [N, 7] for (x, y, z, qx, qy, qz, qw), call between begin_tick() and tick(),
+    # blocks until every frame has been written, so frames must be read concurrently, returns the number of frames written
+    def render_trajectory(self, poses, num_warmup_frames=0, timeout=10.0):
+        assert poses.shape[1] in [6, 7]
+        return self._rpc_client.call("legacy_service.render_trajectory", poses.flatten().tolist(), poses.shape[1], num_warmup_frames, float(timeout))
+
+    # while a dataset writer exists, render_trajectory(...) encodes and writes frames to disk instead of into shared memory,
+    # encodings maps render pass names to "raw", "png", or "exr", render passes that aren't listed are written as "raw"
+    def create_dataset_writer(self, directory, encodings={}):
+        self._rpc_client.call("legacy_service.create_dataset_writer", directory, encodings)
+
+    # blocks until every frame has been written to disk
+    def flush_dataset_writer(self):
+        self._rpc_client.call("legacy_service.flush_dataset_writer")
+
+    def get_dataset_writer_stats(self):
+        return self._rpc_client.call("legacy_service.get_dataset_writer_stats")
+
+    def destroy_dataset_writer(self):
+        self._rpc_client.call("legacy_service.destroy_dataset_writer")
+
+    def destroy_trajectory_renderer(self):
+        self._rpc_client.call("legacy_service.destroy_trajectory_renderer")
+
     def get_random_points(self, num_points):
         random_points = self._rpc_client.call("legacy_service.get_random_points", num_points)
         return np.asarray(random_points, dtype=np.float64).reshape(num_points, 3)
@@ -23,6 +90,42 @@ class LegacyService():
         paths = self._rpc_client.call("legacy_service.get_paths", initial_points.flatten().tolist(), goal_points.flatten().tolist())
         return [ np.asarray(path, dtype=np.float64).reshape(-1, 3) for path in paths ]
 
+    # Finds paths in parallel and returns (points, offsets, statuses, lengths), where path i is points[offsets[i]:offsets[i+1]],
+    # statuses[i] is 0 for success, 1 for a partial path that ends at the reachable point closest to the goal, and 2 for failure.
+    def get_paths_packed(self, initial_points, goal_points):
+        assert initial_points.shape[1] == 3
+        assert goal_points.shape[1] == 3
+        packed_paths = self._rpc_client.call("legacy_service.get_paths_packed", initial_points.flatten().tolist(), goal_points.flatten().tolist())
+        points = np.frombuffer(packed_paths["points"], dtype=np.float64).reshape(-1, 3)
+        offsets = np.frombuffer(packed_paths["offsets"], dtype=np.int64)
+        statuses = np.frombuffer(packed_paths["statuses"], dtype=np.uint8)
+        lengths = np.frombuffer(packed_paths["lengths"], dtype=np.float64)
+        return points, offsets, statuses, lengths
+
+    # Samples points uniformly by area over the navmesh. The same seed always returns the same points for the same navmesh. If
+    # reference_point is set, points are restricted to Euclidean distances in [min_distance, max_distance] from reference_point,
+    # and optionally to polygons reachable from reference_point. Returns an array of shape [M, 3] with M <= num_points.
+    def sample_points(self, num_points, seed, reference_point=None, reachable_from_reference_point=False, min_distance=0.0, max_distance=np.inf, min_separation=0.0):
+        assert reference_point is not None or not reachable_from_reference_point
+        reference_point = [] if reference_point is None else reference_point.tolist()
+        points = self._rpc_client.call(
+            "legacy_service.sample_points", num_points, seed, reference_point, reachable_from_reference_point, min_distance, max_distance, min_separation)
+        return np.frombuffer(points, dtype=np.float64).reshape(-1, 3)
+
+    # computes the geodesic distance from every navmesh polygon to goal_point once, and returns an id for use with get_geodesic_distances(...)
+    def create_geodesic_distance_field(self, goal_point):
+        assert goal_point.shape == (3,)
+        return self._rpc_client.call("legacy_service.create_geodesic_distance_field", goal_point.tolist())
+
+    # returns inf for points that aren't on the navmesh or can't reach the goal
+    def get_geodesic_distances(self, geodesic_distance_field_id, points):
+        assert points.shape[1] == 3
+        distances = self._rpc_client.call("legacy_service.get_geodesic_distances", geodesic_distance_field_id, points.flatten().tolist())
+        return np.asarray(distances, dtype=np.float64)
+
+    def destroy_geodesic_distance_field(self, geodesic_distance_field_id):
+        self._rpc_client.call("legacy_service.destroy_geodesic_distance_field", geodesic_distance_field_id)
+
     def get_action_space(self):
         return self._rpc_client.call("legacy_service.get_action_space")
     
@@ -40,6 +143,10 @@ class LegacyService():
     
     def get_observation(self):
         return self._rpc_client.call("legacy_service.get_observation")
+
+    # sensor_names can contain "camera" and "imu", and only affects sensors configured with UPDATE_ON_DEMAND: True
+    def request_sensor_updates(self, sensor_names):
+        self._rpc_client.call("legacy_service.request_sensor_updates", sensor_names)
     
     def get_reward(self):
         return self._rpc_client.call("legacy_service.get_reward")
@@ -64,3 +171,48 @@ class LegacyService():
 
     def is_agent_ready(self):
         return self._rpc_client.call("legacy_service.is_agent_ready")
+
+    #
+    # vectorized interface, used when SP_SERVICES.LEGACY_SERVICE.NUM_AGENTS is greater than 1, every array has shape [num_agents, ...]
+    #
+
+    def get_num_agents(self):
+        return self._rpc_client.call("legacy_service.get_num_agents")
+
+    def get_vectorized_action_space(self):
+        return self._rpc_client.call("legacy_service.get_vectorized_action_space")
+
+    def get_vectorized_observation_space(self):
+        return self._rpc_client.call("legacy_service.get_vectorized_observation_space")
+
+    def get_vectorized_task_step_info_space(self):
+        return self._rpc_client.call("legacy_service.get_vectorized_task_step_info_space")
+
+    def get_vectorized_agent_step_info_space(self):
+        return self._rpc_client.call("legacy_service.get_vectorized_agent_step_info_space")
+
+    def apply_vectorized_action(self, action):
+        self._rpc_client.call("legacy_service.apply_vectorized_action", action)
+
+    def get_vectorized_observation(self):
+        return self._rpc_client.call("legacy_service.get_vectorized_observation")
+
+    def get_vectorized_rewards(self):
+        return np.asarray(self._rpc_client.call("legacy_service.get_vectorized_rewards"), dtype=np.float32)
+
+    def get_vectorized_task_step_info(self):
+        return self._rpc_client.call("legacy_service.get_vectorized_task_step_info")
+
+    def get_vectorized_agent_step_info(self):
+        return self._rpc_client.call("legacy_service.get_vectorized_agent_step_info")
+
+    # returns a bool array of episode done flags, and resets every agent whose episode is done, call after getting the observation,
+    # rewards, and step info for the current step
+    def auto_reset_vectorized(self):
+        return np.frombuffer(self._rpc_client.call("legacy_service.auto_reset_vectorized"), dtype=np.uint8).astype(bool)
+
+    def reset_vectorized(self):
+        self._rpc_client.call("legacy_service.reset_vectorized")
+
+    def is_vectorized_ready(self):
+        return self._rpc_client.call("legacy_service.is_vectorized_ready")
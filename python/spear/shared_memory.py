@@ -0,0 +1,61 @@
+#
+# Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+#
+
+import mmap
+import multiprocessing.shared_memory
+import numpy as np
+import sys
+
+
+# must be kept in sync with SharedMemoryRegionHeader in cpp/unreal_plugins/SpCore/Source/SpCore/SharedMemoryRegion.h
+REGION_HEADER_DTYPE = np.dtype([
+    ("generation", np.uint64),
+    ("num_bytes", np.uint64),
+    ("id", "S48")])
+
+assert REGION_HEADER_DTYPE.itemsize == 64
+
+
+# Provides access to a shared memory region created with SharedMemoryRegionFlags::Growable. Call get_buffer() before
+# each access, which checks the generation counter in the header and remaps the region if it has been resized.
+class GrowableSharedMemoryRegion():
+    def __init__(self, id):
+        self._shared_memory_object = None
+        self._header = None
+        self._map(id)
+
+    def get_buffer(self):
+        if int(self._header["generation"]) != self._generation:
+            id = self._header["id"].decode("utf-8")
+            self._unmap()
+            self._map(id)
+        return self._buffer
+
+    def close(self):
+        self._unmap()
+
+    def _map(self, id):
+        if sys.platform == "win32":
+            header_mapping = mmap.mmap(-1, REGION_HEADER_DTYPE.itemsize, id)
+            num_bytes = int(np.frombuffer(header_mapping, dtype=REGION_HEADER_DTYPE, count=1)[0]["num_bytes"])
+            header_mapping.close()
+            self._shared_memory_object = mmap.mmap(-1, REGION_HEADER_DTYPE.itemsize + num_bytes, id)
+            buffer = self._shared_memory_object
+        elif sys.platform in ["darwin", "linux"]:
+            self._shared_memory_object = multiprocessing.shared_memory.SharedMemory(name=id.lstrip("/"))
+            buffer = self._shared_memory_object.buf
+        else:
+            assert False
+
+        self._header = np.ndarray(shape=(), dtype=REGION_HEADER_DTYPE, buffer=buffer)
+        self._generation = int(self._header["generation"])
+        self._buffer = np.ndarray(shape=(int(self._header["num_bytes"]),), dtype=np.uint8, buffer=buffer, offset=REGION_HEADER_DTYPE.itemsize)
+
+    def _unmap(self):
+        # the region is owned by the C++ process, so we close our mapping but we don't unlink it
+        self._header = None
+        self._buffer = None
+        if self._shared_memory_object is not None:
+            self._shared_memory_object.close()
+            self._shared_memory_object = None
@@ -519,6 +519,46 @@ class UnrealService():
     def static_load_class(self, base_uclass, in_outer, name="", filename="", load_flags=["LOAD_None"], sandbox=0):
         return self._rpc_client.call("unreal_service.static_load_class", base_uclass, in_outer, name, filename, load_flags, sandbox)
 
+    #
+    # Load objects asynchronously
+    #
+
+    def load_objects_async(self, paths):
+        return self._rpc_client.call("unreal_service.load_objects_async", paths)
+
+    def prefetch_objects(self, paths):
+        return self._rpc_client.call("unreal_service.prefetch_objects", paths)
+
+    def has_async_load_completed(self, handle):
+        return self._rpc_client.call("unreal_service.has_async_load_completed", handle)
+
+    def get_async_load_progress(self, handle):
+        return self._rpc_client.call("unreal_service.get_async_load_progress", handle)
+
+    # a timeout of 0.0 waits indefinitely
+    def wait_for_async_load(self, handle, timeout=0.0):
+        return self._rpc_client.call("unreal_service.wait_for_async_load", handle, timeout)
+
+    def release_async_load(self, handle):
+        self._rpc_client.call("unreal_service.release_async_load", handle)
+
+    #
+    # Save and restore named world snapshots
+    #
+
+    # returns the approximate number of bytes used by the snapshot
+    def save_world_snapshot(self, name, property_names=[]):
+        return self._rpc_client.call("unreal_service.save_world_snapshot", name, property_names)
+
+    def restore_world_snapshot(self, name):
+        self._rpc_client.call("unreal_service.restore_world_snapshot", name)
+
+    def remove_world_snapshot(self, name):
+        self._rpc_client.call("unreal_service.remove_world_snapshot", name)
+
+    def get_world_snapshot_names(self):
+        return self._rpc_client.call("unreal_service.get_world_snapshot_names")
+
     #
     # Find, get, and set console variables
     #
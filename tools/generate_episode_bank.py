@@ -0,0 +1,90 @@
+#
+# Copyright(c) 2022 Intel. Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+#
+
+# Converts an episodes file in the following CSV format into a binary episode bank that can be memory-mapped by
+# ImitationLearningTask and PointGoalNavTask:
+#     scene_id, initial_location_x, initial_location_y, initial_location_z, goal_location_x, goal_location_y, goal_location_z
+#
+# The binary layout must be kept in sync with cpp/unreal_plugins/SpServices/Source/SpServices/Legacy/EpisodeBank.h.
+
+import argparse
+import numpy as np
+import os
+import pandas as pd
+import spear
+
+
+EPISODE_BANK_MAGIC = b"SPEPBANK"
+EPISODE_BANK_VERSION = 1
+
+EPISODE_BANK_HEADER_DTYPE = np.dtype([
+    ("magic", "S8"),
+    ("version", "<u4"),
+    ("episode_num_bytes", "<u4"),
+    ("num_scenes", "<u8"),
+    ("num_episodes", "<u8"),
+    ("scene_table_offset", "<u8"),
+    ("episode_table_offset", "<u8"),
+    ("reserved", "<u8", (2,))])
+
+EPISODE_BANK_SCENE_DTYPE = np.dtype([
+    ("scene_id", "S64"),
+    ("first_episode_index", "<u8"),
+    ("num_episodes", "<u8")])
+
+EPISODE_BANK_EPISODE_DTYPE = np.dtype([
+    ("initial_location", "<f8", (3,)),
+    ("goal_location", "<f8", (3,)),
+    ("scene_index", "<u4"),
+    ("reserved", "<u4")])
+
+assert EPISODE_BANK_HEADER_DTYPE.itemsize == 64
+assert EPISODE_BANK_SCENE_DTYPE.itemsize == 80
+assert EPISODE_BANK_EPISODE_DTYPE.itemsize == 56
+
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--episodes_file", required=True)
+    parser.add_argument("--output_file", required=True)
+    args = parser.parse_args()
+
+    spear.log("Reading episodes file: " + args.episodes_file)
+    df = pd.read_csv(args.episodes_file, dtype={"scene_id": str})
+
+    # episodes for each scene must be contiguous, so we sort by scene while keeping the order of episodes within each scene
+    df = df.sort_values(by="scene_id", kind="stable").reset_index(drop=True)
+    scene_ids, first_episode_indices, num_episodes = np.unique(df["scene_id"].to_numpy(), return_index=True, return_counts=True)
+    assert all([ len(scene_id.encode("utf-8")) < EPISODE_BANK_SCENE_DTYPE["scene_id"].itemsize for scene_id in scene_ids ])
+
+    scenes = np.zeros(len(scene_ids), dtype=EPISODE_BANK_SCENE_DTYPE)
+    scenes["scene_id"] = [ scene_id.encode("utf-8") for scene_id in scene_ids ]
+    scenes["first_episode_index"] = first_episode_indices
+    scenes["num_episodes"] = num_episodes
+
+    episodes = np.zeros(len(df), dtype=EPISODE_BANK_EPISODE_DTYPE)
+    episodes["initial_location"] = df[["initial_location_x", "initial_location_y", "initial_location_z"]].to_numpy(dtype=np.float64)
+    episodes["goal_location"] = df[["goal_location_x", "goal_location_y", "goal_location_z"]].to_numpy(dtype=np.float64)
+    episodes["scene_index"] = np.searchsorted(scene_ids, df["scene_id"].to_numpy())
+
+    header = np.zeros(1, dtype=EPISODE_BANK_HEADER_DTYPE)
+    header["magic"] = EPISODE_BANK_MAGIC
+    header["version"] = EPISODE_BANK_VERSION
+    header["episode_num_bytes"] = EPISODE_BANK_EPISODE_DTYPE.itemsize
+    header["num_scenes"] = len(scenes)
+    header["num_episodes"] = len(episodes)
+    header["scene_table_offset"] = EPISODE_BANK_HEADER_DTYPE.itemsize
+    header["episode_table_offset"] = EPISODE_BANK_HEADER_DTYPE.itemsize + scenes.nbytes
+
+    output_dir = os.path.realpath(os.path.dirname(args.output_file))
+    os.makedirs(output_dir, exist_ok=True)
+
+    with open(args.output_file, "wb") as f:
+        f.write(header.tobytes())
+        f.write(scenes.tobytes())
+        f.write(episodes.tobytes())
+
+    spear.log(f"Wrote {len(episodes)} episodes for {len(scenes)} scenes to episode bank: {args.output_file}")
+    spear.log("Done.")